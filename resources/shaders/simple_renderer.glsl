@@ -4,6 +4,8 @@
 layout(location = 0) in vec4 a_position;
 layout(location = 1) in vec2 a_tex_coord;
 layout(location = 2) in vec4 a_color;
+// Index of the draw within its batch
+layout(location = 3) in float a_draw_id;
 
 out vec2 v_tex_coord;
 out vec4 v_color;
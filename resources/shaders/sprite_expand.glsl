@@ -0,0 +1,56 @@
+#shader compute
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+struct Sprite {
+    vec2 position;
+    vec2 size;
+    float rotation;
+    vec4 color;
+    vec4 uv_rect;
+};
+
+struct Vertex {
+    vec2 position;
+    vec2 tex_coord;
+    vec4 color;
+};
+
+layout(std430, binding = 0) readonly buffer Sprites {
+    Sprite sprites[];
+};
+
+layout(std430, binding = 1) writeonly buffer Vertices {
+    Vertex vertices[];
+};
+
+uniform int u_sprite_count;
+
+// Same corners as Renderer::draw_texture, texture rows go top to bottom
+const vec2 corners[4] = vec2[](vec2(0.0, 1.0), vec2(1.0, 1.0), vec2(1.0, 0.0), vec2(0.0, 0.0));
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= uint(u_sprite_count))
+        return;
+
+    Sprite sprite = sprites[index];
+
+    // Sprites rotate around their center
+    float s = sin(sprite.rotation);
+    float c = cos(sprite.rotation);
+    vec2 center = sprite.position + sprite.size * 0.5;
+
+    for (uint i = 0u; i < 4u; ++i) {
+        vec2 offset = (corners[i] - 0.5) * sprite.size;
+        vec2 rotated = vec2(offset.x * c - offset.y * s, offset.x * s + offset.y * c);
+
+        Vertex vertex;
+        vertex.position = center + rotated;
+        vertex.tex_coord = sprite.uv_rect.xy + vec2(corners[i].x, 1.0 - corners[i].y) * sprite.uv_rect.zw;
+        vertex.color = sprite.color;
+
+        vertices[index * 4u + i] = vertex;
+    }
+}
@@ -0,0 +1,40 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 a_position;
+layout(location = 1) in vec2 a_tex_coord;
+layout(location = 2) in vec4 a_color;
+// Index of the draw within its batch
+layout(location = 3) in float a_draw_id;
+
+out vec2 v_tex_coord;
+out vec4 v_color;
+
+void main() {
+    gl_Position = a_position;
+    v_tex_coord = a_tex_coord;
+    v_color = a_color;
+}
+
+
+#shader fragment
+#version 330 core
+
+// The stress executable builds one program per variant by defining
+// VARIANT, each variant shades its sprites slightly differently
+#ifndef VARIANT
+#define VARIANT 0
+#endif
+
+out vec4 frag_color;
+
+uniform sampler2D u_texture_slot;
+
+in vec2 v_tex_coord;
+in vec4 v_color;
+
+void main() {
+    vec4 tex_color = texture(u_texture_slot, v_tex_coord);
+    float shade = 1.0 - float(VARIANT % 8) * 0.05;
+    frag_color = vec4(tex_color.rgb * v_color.rgb * shade, tex_color.a * v_color.a);
+}
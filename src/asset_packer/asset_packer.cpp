@@ -0,0 +1,151 @@
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "opengl/asset_pack.hpp"
+#include "opengl/compressed_image.hpp"
+#include "opengl/image.hpp"
+
+static void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " <output> <kind>:<name>=<path>...\n"
+              << "Kinds:\n"
+              << "    shader              shader file, stored as is\n"
+              << "    texture             image, stored pre-decoded\n"
+              << "    texture_flipped     image flipped vertically, stored pre-decoded\n"
+              << "    compressed_texture  DDS or KTX2 file, stored as is\n"
+              << "    mesh                text mesh of `vertex` and `index` lines\n";
+}
+
+// Text meshes hold one `vertex <float>...` line per vertex, every vertex
+// having the same number of components, and `index <uint>...` lines
+static bool add_mesh(GL::AssetPackWriter& writer,
+                     const std::string& name, const std::string& path)
+{
+    std::ifstream stream(path);
+    if (!stream) {
+        std::cerr << "ERROR: could not open mesh `" << path << "`\n";
+        return false;
+    }
+
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+    std::size_t components = 0;
+
+    std::string line;
+    std::size_t line_number = 0;
+    while (getline(stream, line)) {
+        line_number += 1;
+
+        std::istringstream words(line);
+        std::string keyword;
+        if (!(words >> keyword) || keyword[0] == '#')
+            continue;
+
+        if (keyword == "vertex") {
+            std::size_t count = 0;
+            float value;
+            while (words >> value) {
+                vertices.push_back(value);
+                count += 1;
+            }
+
+            if (components == 0)
+                components = count;
+
+            if (count == 0 || count != components) {
+                std::cerr << path << ":" << line_number
+                          << ": ERROR: vertices must all have the same number of components\n";
+                return false;
+            }
+        } else if (keyword == "index") {
+            GLuint value;
+            while (words >> value) {
+                indices.push_back(value);
+            }
+        } else {
+            std::cerr << path << ":" << line_number
+                      << ": ERROR: unknown keyword `" << keyword << "`\n";
+            return false;
+        }
+    }
+
+    std::size_t vertex_count = components == 0 ? 0 : vertices.size() / components;
+    return writer.add_mesh(name, vertices.data(), components * sizeof(float), vertex_count,
+                           indices.data(), indices.size());
+}
+
+static bool add_asset(GL::AssetPackWriter& writer, const std::string& argument)
+{
+    auto colon = argument.find(':');
+    auto equals = argument.find('=', colon);
+    if (colon == std::string::npos || equals == std::string::npos) {
+        std::cerr << "ERROR: expected <kind>:<name>=<path>, got `" << argument << "`\n";
+        return false;
+    }
+
+    std::string kind = argument.substr(0, colon);
+    std::string name = argument.substr(colon + 1, equals - colon - 1);
+    std::string path = argument.substr(equals + 1);
+
+    if (kind == "shader") {
+        std::vector<unsigned char> bytes;
+        if (!GL::read_file(path, bytes))
+            return false;
+
+        return writer.add(name, GL::AssetType::SHADER, std::move(bytes));
+    }
+
+    if (kind == "texture" || kind == "texture_flipped") {
+        GL::Image image = GL::load_image(path, kind == "texture_flipped");
+        if (!image.is_valid())
+            return false;
+
+        return writer.add(name, GL::AssetType::TEXTURE, GL::encode_raw_image(image));
+    }
+
+    if (kind == "compressed_texture") {
+        std::vector<unsigned char> bytes;
+        if (!GL::read_file(path, bytes))
+            return false;
+
+        GL::PixelFormat format;
+        std::vector<GL::TextureLevel> levels;
+        if (!GL::parse_compressed_image(bytes.data(), bytes.size(), format, levels)) {
+            std::cerr << "ERROR: could not load compressed image `" << path << "`\n";
+            return false;
+        }
+
+        return writer.add(name, GL::AssetType::TEXTURE, std::move(bytes));
+    }
+
+    if (kind == "mesh") {
+        return add_mesh(writer, name, path);
+    }
+
+    std::cerr << "ERROR: unknown asset kind `" << kind << "`\n";
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    GL::AssetPackWriter writer;
+
+    for (int i = 2; i < argc; ++i) {
+        if (!add_asset(writer, argv[i]))
+            return 1;
+    }
+
+    if (!writer.write(argv[1]))
+        return 1;
+
+    return 0;
+}
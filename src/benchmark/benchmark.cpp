@@ -0,0 +1,502 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "opengl/context.hpp"
+#include "opengl/gl_dispatch.hpp"
+#include "opengl/gl_errors.hpp"
+#include "opengl/render_queue.hpp"
+#include "opengl/shader.hpp"
+#include "opengl/texture.hpp"
+#include "opengl/vertex_array.hpp"
+#include "opengl/vertex_buffer.hpp"
+
+// Matches the vertex layout of simple_renderer.glsl: position, uv, color
+#define VERTEX_FLOATS 8
+#define QUAD_INDEX_COUNT 6
+#define DRAW_ID_LOCATION 3
+
+#define TEXTURE_COUNT 4
+
+struct Result {
+    std::string name;
+    // The size of the measured batch, what it counts depends on the case
+    std::size_t batch;
+    std::size_t iterations;
+    double seconds;
+    // Operations and bytes done by a single iteration
+    std::size_t operations;
+    std::size_t bytes;
+};
+
+class Benchmark {
+private:
+    double m_min_seconds;
+    std::vector<Result> m_results;
+
+public:
+    Benchmark(double min_seconds)
+        : m_min_seconds(min_seconds)
+    {
+    }
+
+    // Runs `iteration` until `m_min_seconds` have passed. GL work is
+    // finished before the clock stops, so that work the driver deferred is
+    // part of the measure.
+    void run(const std::string& name, std::size_t batch,
+             std::size_t operations, std::size_t bytes,
+             const std::function<void()>& iteration)
+    {
+        // Warms up the buffers, so that growing them on the first
+        // iteration does not count
+        iteration();
+        gl(Finish, ());
+
+        using Clock = std::chrono::steady_clock;
+
+        std::size_t iterations = 0;
+        auto start = Clock::now();
+        std::chrono::duration<double> elapsed;
+        do {
+            iteration();
+            gl(Finish, ());
+            iterations += 1;
+            elapsed = Clock::now() - start;
+        } while (elapsed.count() < m_min_seconds);
+
+        m_results.push_back({
+            .name = name,
+            .batch = batch,
+            .iterations = iterations,
+            .seconds = elapsed.count(),
+            .operations = operations,
+            .bytes = bytes,
+        });
+
+        const Result& result = m_results.back();
+        std::cout << "[INFO] " << name << " (" << batch << "): "
+                  << result.operations * result.iterations / result.seconds << " ops/s\n";
+    }
+
+    void write_json(std::ostream& out, const std::string& renderer) const
+    {
+        out << "{\n";
+        out << "  \"renderer\": \"" << renderer << "\",\n";
+        out << "  \"results\": [\n";
+
+        for (std::size_t i = 0; i < m_results.size(); ++i) {
+            const Result& result = m_results[i];
+            double operations = double(result.operations) * result.iterations;
+            double bytes = double(result.bytes) * result.iterations;
+
+            out << "    { "
+                << "\"name\": \"" << result.name << "\", "
+                << "\"batch\": " << result.batch << ", "
+                << "\"iterations\": " << result.iterations << ", "
+                << "\"seconds\": " << result.seconds << ", "
+                << "\"ops_per_second\": " << operations / result.seconds << ", "
+                << "\"mb_per_second\": " << bytes / result.seconds / (1024.0 * 1024.0)
+                << " }" << (i + 1 < m_results.size() ? "," : "") << "\n";
+        }
+
+        out << "  ]\n";
+        out << "}\n";
+    }
+};
+
+static std::string json_escape(const char* text)
+{
+    std::string escaped;
+    for (; text != nullptr && *text != '\0'; ++text) {
+        if (*text == '"' || *text == '\\')
+            escaped += '\\';
+        escaped += *text;
+    }
+    return escaped;
+}
+
+static GL::VertexLayout renderer_layout()
+{
+    GL::VertexLayout layout;
+    layout.add_attribute<float>(2, false);
+    layout.add_attribute<float>(2, false);
+    layout.add_attribute<float>(4, false);
+    return layout;
+}
+
+static void quad_vertices(std::size_t index, std::size_t count, float vertices[4][VERTEX_FLOATS])
+{
+    float size = 2.0f / count;
+    float x = -1.0f + index * size;
+
+    float quad[4][VERTEX_FLOATS] = {
+        { x, -1.0f + size, 0, 0, 1, 1, 1, 1 },
+        { x + size, -1.0f + size, 1, 0, 1, 1, 1, 1 },
+        { x + size, -1.0f, 1, 1, 1, 1, 1, 1 },
+        { x, -1.0f, 0, 1, 1, 1, 1, 1 },
+    };
+    std::memcpy(vertices, quad, sizeof(quad));
+}
+
+static void benchmark_buffers(Benchmark& benchmark)
+{
+    static const std::size_t batch_sizes[] = { 1, 16, 256, 4096 };
+
+    GL::VertexArray* va = new GL::VertexArray();
+    va->bind();
+    GL::VertexBuffer* vb = va->bind_vertex_buffer(renderer_layout());
+    GL::IndexBuffer* ib = va->bind_index_buffer();
+    vb->bind();
+    ib->bind();
+
+    std::vector<float> vertices(4096 * VERTEX_FLOATS, 0.5f);
+    std::vector<GLuint> indices(4096, 0);
+    std::size_t vertex_size = VERTEX_FLOATS * sizeof(float);
+
+    for (std::size_t batch : batch_sizes) {
+        benchmark.run("push_vertex", batch, batch, batch * vertex_size, [&] {
+            vb->clear();
+            for (std::size_t i = 0; i < batch; ++i)
+                vb->push_vertex(&vertices[i * VERTEX_FLOATS], vertex_size);
+        });
+
+        benchmark.run("push_vertices", batch, batch, batch * vertex_size, [&] {
+            vb->clear();
+            vb->push_vertices(vertices.data(), batch);
+        });
+
+        benchmark.run("push_index", batch, batch, batch * sizeof(GLuint), [&] {
+            ib->clear();
+            for (std::size_t i = 0; i < batch; ++i)
+                ib->push_index(indices[i]);
+        });
+
+        benchmark.run("push_indices", batch, batch, batch * sizeof(GLuint), [&] {
+            ib->clear();
+            ib->push_indices(indices.data(), batch);
+        });
+    }
+
+    // Vertices pushed one at a time into a new buffer, the cost is
+    // dominated by how the buffer grows. The buffers get their own vertex
+    // array, creating them points its attributes at them.
+    GL::VertexArray* growth_va = new GL::VertexArray();
+    growth_va->bind();
+    static const std::size_t growth_sizes[] = { 64, 256, 1024 };
+    for (std::size_t count : growth_sizes) {
+        benchmark.run("resize_growth", count, count, count * vertex_size, [&] {
+            GL::VertexBuffer* growing = new GL::VertexBuffer(renderer_layout());
+            growing->bind();
+            for (std::size_t i = 0; i < count; ++i)
+                growing->push_vertex(&vertices[i * VERTEX_FLOATS], vertex_size);
+            delete growing;
+        });
+    }
+    delete growth_va;
+
+    // Rewrites the color of scattered vertices of a full buffer
+    va->bind();
+    vb->bind();
+    vb->clear();
+    vb->push_vertices(vertices.data(), 4096);
+    for (std::size_t batch : batch_sizes) {
+        benchmark.run("set_attribute", batch, batch, batch * 4 * sizeof(float), [&] {
+            float color[4] = { 1, 0, 0, 1 };
+            for (std::size_t i = 0; i < batch; ++i)
+                vb->set_attribute((i * 7919) % 4096, 2, color, sizeof(color));
+        });
+    }
+
+    va->unbind_all();
+    delete va;
+}
+
+static void benchmark_uniforms(Benchmark& benchmark, GL::Shader& shader)
+{
+    static const std::size_t batch = 1000;
+
+    shader.bind();
+    // Alternating values, so that every call reaches GL
+    benchmark.run("set_uniform", batch, batch, 0, [&] {
+        for (std::size_t i = 0; i < batch; ++i)
+            shader.set_uniform("u_texture_slot", static_cast<int>(i % 2));
+    });
+    benchmark.run("set_uniform_unchanged", batch, batch, 0, [&] {
+        for (std::size_t i = 0; i < batch; ++i)
+            shader.set_uniform("u_texture_slot", 0);
+    });
+    shader.unbind();
+}
+
+static void benchmark_textures(Benchmark& benchmark)
+{
+    static const std::size_t sizes[] = { 64, 256, 1024 };
+
+    for (std::size_t size : sizes) {
+        std::vector<unsigned char> pixels(size * size * 4, 0x80);
+        GL::Texture texture(pixels.data(), size, size, GL::PixelFormat::R8G8B8A8, GL::TextureType::TWO_DIMS);
+
+        benchmark.run("texture_update", size, 1, pixels.size(), [&] {
+            texture.update_region(0, 0, size, size, pixels.data());
+        });
+
+        benchmark.run("texture_create", size, 1, pixels.size(), [&] {
+            GL::Texture created(pixels.data(), size, size, GL::PixelFormat::R8G8B8A8, GL::TextureType::TWO_DIMS);
+        });
+    }
+}
+
+// Draws textured quads the way simple_renderer does: vertices appended to
+// one buffer, drawn from a shared index pattern through the render queue
+static void benchmark_renderer(Benchmark& benchmark, GL::Shader& shader)
+{
+    static const std::size_t draw_counts[] = { 1, 100, 10000 };
+
+    GL::VertexArray* va = new GL::VertexArray();
+    va->bind();
+    GL::VertexBuffer* vb = va->bind_vertex_buffer(renderer_layout());
+    GL::IndexBuffer* ib = va->bind_index_buffer();
+
+    GLuint quad_indices[] = { 0, 1, 2, 2, 3, 0 };
+    ib->push_indices(quad_indices, QUAD_INDEX_COUNT);
+
+    GL::RenderQueue* queue = new GL::RenderQueue();
+    queue->draws().enable_draw_id(DRAW_ID_LOCATION);
+    va->unbind_all();
+
+    std::vector<GL::Texture*> textures;
+    for (int i = 0; i < TEXTURE_COUNT; ++i) {
+        unsigned char pixel[] = { static_cast<unsigned char>(i * 64), 0xFF, 0xFF, 0xFF };
+        textures.push_back(new GL::Texture(pixel, 1, 1, GL::PixelFormat::R8G8B8A8, GL::TextureType::TWO_DIMS));
+    }
+
+    shader.bind();
+    shader.set_uniform("u_texture_slot", 0);
+
+    for (std::size_t draw_count : draw_counts) {
+        benchmark.run("renderer_draws", draw_count, draw_count, 0, [&] {
+            gl(Clear, (GL_COLOR_BUFFER_BIT));
+
+            va->bind();
+            ib->bind();
+            vb->bind();
+            vb->clear();
+
+            for (std::size_t i = 0; i < draw_count; ++i) {
+                float vertices[4][VERTEX_FLOATS];
+                quad_vertices(i, draw_count, vertices);
+
+                queue->push({
+                    .layer = 0,
+                    .translucent = false,
+                    .depth = 0.0f,
+                    .shader = &shader,
+                    .texture = textures[i % TEXTURE_COUNT],
+                    .vertex_array = va,
+                    .index_buffer = ib,
+                    .mode = GL_TRIANGLES,
+                    .first_index = 0,
+                    .index_count = QUAD_INDEX_COUNT,
+                    .base_vertex = static_cast<GLint>(vb->vertex_count()),
+                });
+                vb->push_vertices(vertices[0], 4);
+            }
+
+            queue->submit();
+        });
+    }
+
+    for (GL::Texture* texture : textures)
+        delete texture;
+    delete queue;
+    delete va;
+}
+
+#ifdef OPENGL_GL_DISPATCH
+static bool expect_calls(const char* name, GL::GLFunction function, std::size_t expected)
+{
+    std::size_t calls = GL::gl_recording().count(function);
+    if (calls == expected)
+        return true;
+
+    std::cerr << "ERROR: " << name << ": " << GL::gl_function_name(function) << " called "
+              << calls << " times, expected " << expected << "\n";
+    return false;
+}
+
+static bool expect_draw_calls(const char* name, std::size_t expected)
+{
+    std::size_t draw_calls = GL::gl_recording().draw_calls;
+    if (draw_calls == expected)
+        return true;
+
+    std::cerr << "ERROR: " << name << ": " << draw_calls << " draw calls, expected " << expected << "\n";
+    return false;
+}
+
+// Runs the benchmarked paths on the recording backend, without a context,
+// and checks how many GL calls they make. Returns false on any mismatch.
+static bool count_calls(const char* shader_path)
+{
+    using GL::GLFunction;
+
+    GL::set_gl_backend(GL::GLBackend::RECORDING);
+    bool passed = true;
+
+    GL::VertexArray* va = new GL::VertexArray();
+    va->bind();
+    GL::VertexBuffer* vb = va->bind_vertex_buffer(renderer_layout());
+    GL::IndexBuffer* ib = va->bind_index_buffer();
+    vb->bind();
+    ib->bind();
+
+    std::vector<float> vertices(16 * VERTEX_FLOATS, 0.5f);
+    std::size_t vertex_size = VERTEX_FLOATS * sizeof(float);
+
+    // One upload per vertex once the buffer is big enough
+    vb->resize(16 * vertex_size);
+    GL::reset_gl_recording();
+    for (std::size_t i = 0; i < 16; ++i)
+        vb->push_vertex(&vertices[i * VERTEX_FLOATS], vertex_size);
+    passed &= expect_calls("push_vertex", GLFunction::BufferSubData, 16);
+    passed &= expect_calls("push_vertex", GLFunction::BufferData, 0);
+
+    vb->clear();
+    GL::reset_gl_recording();
+    vb->push_vertices(vertices.data(), 16);
+    passed &= expect_calls("push_vertices", GLFunction::BufferSubData, 1);
+    passed &= expect_calls("push_vertices", GLFunction::BufferData, 0);
+
+    GLuint quad_indices[] = { 0, 1, 2, 2, 3, 0 };
+    ib->push_indices(quad_indices, QUAD_INDEX_COUNT);
+    va->unbind_all();
+
+    // The location is looked up once, values already set are skipped
+    GL::Shader* shader = new GL::Shader(shader_path);
+    shader->bind();
+    GL::reset_gl_recording();
+    shader->set_uniform("u_texture_slot", 0);
+    shader->set_uniform("u_texture_slot", 0);
+    shader->set_uniform("u_texture_slot", 1);
+    passed &= expect_calls("set_uniform", GLFunction::GetUniformLocation, 1);
+    passed &= expect_calls("set_uniform", GLFunction::Uniform1i, 2);
+
+    std::vector<GL::Texture*> textures;
+    for (int i = 0; i < 2; ++i) {
+        unsigned char pixel[] = { static_cast<unsigned char>(i * 64), 0xFF, 0xFF, 0xFF };
+        textures.push_back(new GL::Texture(pixel, 1, 1, GL::PixelFormat::R8G8B8A8, GL::TextureType::TWO_DIMS));
+    }
+
+    // Opaque quads alternating between two textures are sorted into one
+    // multi draw per texture. Draw ids are not enabled, without indirect
+    // draws they would take a draw call per quad.
+    GL::RenderQueue* queue = new GL::RenderQueue();
+    GL::reset_gl_recording();
+    for (std::size_t i = 0; i < 8; ++i) {
+        queue->push({
+            .layer = 0,
+            .translucent = false,
+            .depth = 0.0f,
+            .shader = shader,
+            .texture = textures[i % 2],
+            .vertex_array = va,
+            .index_buffer = ib,
+            .mode = GL_TRIANGLES,
+            .first_index = 0,
+            .index_count = QUAD_INDEX_COUNT,
+            .base_vertex = static_cast<GLint>(i * 4),
+        });
+    }
+    queue->submit();
+    passed &= expect_draw_calls("renderer", 2);
+    passed &= expect_calls("renderer", GLFunction::UseProgram, 1);
+    passed &= expect_calls("renderer", GLFunction::BindTexture, 2);
+    passed &= expect_calls("renderer", GLFunction::BindVertexArray, 1);
+
+    delete queue;
+    for (GL::Texture* texture : textures)
+        delete texture;
+    delete shader;
+    delete va;
+
+    GL::set_gl_backend(GL::GLBackend::GLEW);
+
+    return passed;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+    // `--output <path>` sets where the results are written, `--min-time
+    // <seconds>` how long each case runs, and the shader drawn with
+    // defaults to the simple renderer's. `--count-calls` checks the GL
+    // calls of the benchmarked paths on the recording backend instead,
+    // which needs the gl_dispatch option but no context.
+    const char* output_path = "benchmark.json";
+    const char* shader_path = "./resources/shaders/simple_renderer.glsl";
+    double min_seconds = 0.2;
+    bool count_calls_only = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--count-calls") == 0) {
+            count_calls_only = true;
+        } else if (std::strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_seconds = std::atof(argv[++i]);
+        } else {
+            shader_path = argv[i];
+        }
+    }
+
+    if (count_calls_only) {
+#ifdef OPENGL_GL_DISPATCH
+        if (!count_calls(shader_path))
+            return 1;
+
+        std::cout << "[INFO] GL call counts match\n";
+        return 0;
+#else
+        std::cerr << "ERROR: --count-calls needs the library built with the gl_dispatch option\n";
+        return 1;
+#endif
+    }
+
+    GL::ContextConfig config = { .title = "Benchmark", .headless = true };
+    GL::Context* context = GL::create_context(config);
+    if (context == nullptr)
+        return 1;
+
+    GL::Shader* shader = new GL::Shader(shader_path);
+    if (!shader->is_valid()) {
+        delete shader;
+        delete context;
+        return 1;
+    }
+
+    Benchmark benchmark(min_seconds);
+    benchmark_buffers(benchmark);
+    benchmark_uniforms(benchmark, *shader);
+    benchmark_textures(benchmark);
+    benchmark_renderer(benchmark, *shader);
+
+    std::string renderer = json_escape(reinterpret_cast<const char*>(gl_fn(GetString)(GL_RENDERER)));
+    std::ofstream output(output_path);
+    if (!output) {
+        std::cerr << "ERROR: could not write `" << output_path << "`\n";
+        delete shader;
+        delete context;
+        return 1;
+    }
+    benchmark.write_json(output, renderer);
+    std::cout << "[INFO] Results written to " << output_path << "\n";
+
+    delete shader;
+    delete context;
+}
@@ -0,0 +1,151 @@
+#include "opengl/asset_loader.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "opengl/trace.hpp"
+
+namespace GL {
+
+AssetLoader::AssetLoader(const Texture* placeholder, std::size_t worker_count)
+{
+    m_placeholder = placeholder;
+
+    if (worker_count == 0) {
+        worker_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        m_workers.emplace_back(&AssetLoader::worker_loop, this);
+    }
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_requests_mutex);
+        m_stopping = true;
+    }
+    m_requests_condition.notify_all();
+
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+
+    for (Texture* texture : m_textures) {
+        delete texture;
+    }
+}
+
+void AssetLoader::worker_loop()
+{
+    while (true) {
+        Request request;
+
+        {
+            std::unique_lock<std::mutex> lock(m_requests_mutex);
+            m_requests_condition.wait(lock, [this] {
+                return m_stopping || !m_requests.empty();
+            });
+
+            if (m_stopping)
+                return;
+
+            request = std::move(m_requests.front());
+            m_requests.pop_front();
+        }
+
+        Image image = load_image(request.path, request.flip_vertically);
+
+        std::lock_guard<std::mutex> lock(m_decoded_mutex);
+        m_decoded.push_back({
+            .handle = request.handle,
+            .path = std::move(request.path),
+            .image = std::move(image),
+        });
+    }
+}
+
+AssetLoader::Handle AssetLoader::load_texture(const std::string& path,
+                                              bool flip_vertically)
+{
+    Handle handle = m_textures.size();
+    m_textures.push_back(nullptr);
+    m_pending_count += 1;
+
+    {
+        std::lock_guard<std::mutex> lock(m_requests_mutex);
+        m_requests.push_back({
+            .handle = handle,
+            .path = path,
+            .flip_vertically = flip_vertically,
+        });
+    }
+    m_requests_condition.notify_one();
+
+    return handle;
+}
+
+AssetLoader::Handle AssetLoader::add_texture(Texture* texture)
+{
+    Handle handle = m_textures.size();
+    m_textures.push_back(texture);
+
+    return handle;
+}
+
+void AssetLoader::upload_pending(std::size_t byte_budget,
+                                 std::chrono::microseconds time_budget)
+{
+    trace_scope("AssetLoader::upload_pending");
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t uploaded_bytes = 0;
+
+    while (true) {
+        Decoded decoded;
+
+        {
+            std::lock_guard<std::mutex> lock(m_decoded_mutex);
+            if (m_decoded.empty())
+                return;
+
+            decoded = std::move(m_decoded.front());
+            m_decoded.pop_front();
+        }
+
+        m_pending_count -= 1;
+
+        // Failed decodes were already reported by `load_image()`, the handle
+        // keeps resolving to the placeholder
+        if (decoded.image.is_valid()) {
+            m_textures[decoded.handle] = new Texture(decoded.image.pixels(),
+                                                     decoded.image.width,
+                                                     decoded.image.height,
+                                                     decoded.image.format,
+                                                     TextureType::TWO_DIMS);
+            m_textures[decoded.handle]->set_label(decoded.path);
+            uploaded_bytes += decoded.image.byte_size();
+        }
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (uploaded_bytes >= byte_budget || elapsed >= time_budget)
+            return;
+    }
+}
+
+void AssetLoader::finish()
+{
+    while (m_pending_count > 0) {
+        upload_pending(SIZE_MAX, std::chrono::microseconds::max());
+        std::this_thread::yield();
+    }
+}
+
+const Texture& AssetLoader::texture(Handle handle) const
+{
+    const Texture* texture = m_textures[handle];
+    return texture != nullptr ? *texture : *m_placeholder;
+}
+
+}
@@ -0,0 +1,300 @@
+#include "opengl/asset_pack.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "opengl/compressed_image.hpp"
+#include "opengl/image.hpp"
+
+static const char asset_pack_magic[4] = { 'G', 'L', 'P', 'K' };
+
+static std::size_t align_up(std::size_t value)
+{
+    return (value + ASSET_PACK_ALIGNMENT - 1) & ~std::size_t(ASSET_PACK_ALIGNMENT - 1);
+}
+
+namespace GL {
+
+AssetPack::AssetPack(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR: could not open asset pack `" << path << "`\n";
+        return;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) < 0 || std::size_t(file_stat.st_size) < sizeof(AssetPackHeader)) {
+        std::cerr << "ERROR: `" << path << "` is not an asset pack\n";
+        close(fd);
+        return;
+    }
+
+    void* mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) {
+        std::cerr << "ERROR: could not map asset pack `" << path << "`\n";
+        return;
+    }
+
+    m_data = static_cast<const unsigned char*>(mapping);
+    m_size = file_stat.st_size;
+
+    // Packs are read front to back at startup
+    madvise(mapping, m_size, MADV_WILLNEED);
+
+    const auto* header = reinterpret_cast<const AssetPackHeader*>(m_data);
+    if (std::memcmp(header->magic, asset_pack_magic, sizeof(asset_pack_magic)) != 0
+        || header->version != ASSET_PACK_VERSION
+        || sizeof(AssetPackHeader) + header->entry_count * sizeof(AssetPackEntry) > m_size) {
+        std::cerr << "ERROR: `" << path << "` is not a version "
+                  << ASSET_PACK_VERSION << " asset pack\n";
+        munmap(mapping, m_size);
+        m_data = nullptr;
+        return;
+    }
+
+    const auto* entries = reinterpret_cast<const AssetPackEntry*>(m_data + sizeof(AssetPackHeader));
+    for (std::uint32_t i = 0; i < header->entry_count; ++i) {
+        const AssetPackEntry& entry = entries[i];
+
+        if (entry.offset + entry.size > m_size) {
+            std::cerr << "ERROR: " << path << ": asset " << i << " is out of bounds\n";
+            continue;
+        }
+
+        std::string_view name(entry.name, strnlen(entry.name, ASSET_PACK_NAME_SIZE));
+        m_assets[name] = {
+            .type = entry.type,
+            .data = m_data + entry.offset,
+            .size = entry.size,
+        };
+    }
+}
+
+AssetPack::~AssetPack()
+{
+    if (m_data != nullptr)
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+const AssetView* AssetPack::find(std::string_view name) const
+{
+    auto it = m_assets.find(name);
+    return it != m_assets.end() ? &it->second : nullptr;
+}
+
+const AssetView* AssetPack::find(std::string_view name, AssetType type) const
+{
+    const AssetView* asset = find(name);
+
+    if (asset == nullptr || asset->type != type) {
+        std::cerr << "ERROR: asset pack has no "
+                  << (type == AssetType::SHADER ? "shader" : type == AssetType::TEXTURE ? "texture" : "mesh")
+                  << " named `" << name << "`\n";
+        return nullptr;
+    }
+
+    return asset;
+}
+
+Shader* AssetPack::load_shader(std::string_view name) const
+{
+    const AssetView* asset = find(name, AssetType::SHADER);
+    if (asset == nullptr)
+        return nullptr;
+
+    return new Shader(std::string(name),
+                      std::string_view(reinterpret_cast<const char*>(asset->data), asset->size));
+}
+
+ComputeShader* AssetPack::load_compute_shader(std::string_view name) const
+{
+    const AssetView* asset = find(name, AssetType::SHADER);
+    if (asset == nullptr)
+        return nullptr;
+
+    return new ComputeShader(std::string(name),
+                             std::string_view(reinterpret_cast<const char*>(asset->data), asset->size));
+}
+
+Texture* AssetPack::load_texture(std::string_view name) const
+{
+    const AssetView* asset = find(name, AssetType::TEXTURE);
+    if (asset == nullptr)
+        return nullptr;
+
+    Texture* texture = nullptr;
+
+    ImageView image;
+    PixelFormat format;
+    std::vector<TextureLevel> levels;
+    if (view_raw_image(asset->data, asset->size, image)) {
+        texture = new Texture(image.pixels, image.width, image.height,
+                              image.format, TextureType::TWO_DIMS);
+    } else if (parse_compressed_image(asset->data, asset->size, format, levels)) {
+        texture = new Texture(levels, format, TextureType::TWO_DIMS);
+    }
+
+    if (texture != nullptr) {
+        texture->set_label(std::string(name));
+        return texture;
+    }
+
+    std::cerr << "ERROR: texture `" << name << "` has an unknown payload\n";
+    return nullptr;
+}
+
+bool AssetPack::mesh(std::string_view name, std::size_t vertex_stride, MeshView& mesh) const
+{
+    const AssetView* asset = find(name, AssetType::MESH);
+    if (asset == nullptr || asset->size < sizeof(AssetPackMeshHeader))
+        return false;
+
+    const auto* header = reinterpret_cast<const AssetPackMeshHeader*>(asset->data);
+
+    if (header->vertex_stride != vertex_stride) {
+        std::cerr << "ERROR: mesh `" << name << "` has a vertex stride of "
+                  << header->vertex_stride << " bytes, " << vertex_stride << " were expected\n";
+        return false;
+    }
+
+    // The counts come from the file, their sizes are computed in 64 bits
+    // and checked one by one so that nothing wraps around
+    std::uint64_t vertices_size = std::uint64_t(header->vertex_stride) * header->vertex_count;
+    std::uint64_t indices_size = std::uint64_t(header->index_count) * sizeof(GLuint);
+
+    std::size_t vertices_offset = align_up(sizeof(AssetPackMeshHeader));
+    if (vertices_size > asset->size || indices_size > asset->size
+        || align_up(vertices_offset + vertices_size) + indices_size > asset->size) {
+        std::cerr << "ERROR: mesh `" << name << "` is truncated\n";
+        return false;
+    }
+
+    std::size_t indices_offset = align_up(vertices_offset + vertices_size);
+
+    mesh = {
+        .vertices = asset->data + vertices_offset,
+        .vertex_stride = header->vertex_stride,
+        .vertex_count = header->vertex_count,
+        .indices = reinterpret_cast<const GLuint*>(asset->data + indices_offset),
+        .index_count = header->index_count,
+    };
+
+    return true;
+}
+
+bool AssetPackWriter::add(const std::string& name, AssetType type,
+                          std::vector<unsigned char> data)
+{
+    if (name.size() >= ASSET_PACK_NAME_SIZE) {
+        std::cerr << "ERROR: asset name `" << name << "` is longer than "
+                  << ASSET_PACK_NAME_SIZE - 1 << " characters\n";
+        return false;
+    }
+
+    for (const Asset& asset : m_assets) {
+        if (asset.name == name) {
+            std::cerr << "ERROR: duplicate asset name `" << name << "`\n";
+            return false;
+        }
+    }
+
+    m_assets.push_back({
+        .name = name,
+        .type = type,
+        .data = std::move(data),
+    });
+
+    return true;
+}
+
+bool AssetPackWriter::add_mesh(const std::string& name,
+                               const void* vertices, std::size_t vertex_stride, std::size_t vertex_count,
+                               const GLuint* indices, std::size_t index_count)
+{
+    std::size_t vertices_offset = align_up(sizeof(AssetPackMeshHeader));
+    std::size_t vertices_size = vertex_stride * vertex_count;
+    std::size_t indices_offset = align_up(vertices_offset + vertices_size);
+
+    std::vector<unsigned char> data(indices_offset + index_count * sizeof(GLuint));
+
+    AssetPackMeshHeader header = {
+        .vertex_stride = std::uint32_t(vertex_stride),
+        .vertex_count = std::uint32_t(vertex_count),
+        .index_count = std::uint32_t(index_count),
+        .reserved = 0,
+    };
+
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + vertices_offset, vertices, vertices_size);
+    std::memcpy(data.data() + indices_offset, indices, index_count * sizeof(GLuint));
+
+    return add(name, AssetType::MESH, std::move(data));
+}
+
+bool AssetPackWriter::write(const std::string& path) const
+{
+    AssetPackHeader header = {};
+    std::memcpy(header.magic, asset_pack_magic, sizeof(asset_pack_magic));
+    header.version = ASSET_PACK_VERSION;
+    header.entry_count = m_assets.size();
+
+    std::vector<AssetPackEntry> entries(m_assets.size());
+
+    std::size_t offset = align_up(sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry));
+    for (std::size_t i = 0; i < m_assets.size(); ++i) {
+        AssetPackEntry& entry = entries[i];
+
+        std::memset(&entry, 0, sizeof(entry));
+        std::memcpy(entry.name, m_assets[i].name.data(), m_assets[i].name.size());
+        entry.type = m_assets[i].type;
+        entry.offset = offset;
+        entry.size = m_assets[i].data.size();
+
+        offset = align_up(offset + entry.size);
+    }
+
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream) {
+        std::cerr << "ERROR: could not open `" << path << "` for writing\n";
+        return false;
+    }
+
+    const char padding[ASSET_PACK_ALIGNMENT] = { 0 };
+    std::size_t position = 0;
+
+    auto write_bytes = [&](const void* data, std::size_t size) {
+        stream.write(static_cast<const char*>(data), size);
+        position += size;
+    };
+
+    auto pad_to = [&](std::size_t target) {
+        stream.write(padding, target - position);
+        position = target;
+    };
+
+    write_bytes(&header, sizeof(header));
+    write_bytes(entries.data(), entries.size() * sizeof(AssetPackEntry));
+
+    for (std::size_t i = 0; i < m_assets.size(); ++i) {
+        pad_to(entries[i].offset);
+        write_bytes(m_assets[i].data.data(), m_assets[i].data.size());
+    }
+
+    if (!stream) {
+        std::cerr << "ERROR: could not write `" << path << "`\n";
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,254 @@
+#include "opengl/command_buffer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#include "opengl/gl_errors.hpp"
+#include "opengl/trace.hpp"
+
+#define COMMAND_ALIGNMENT alignof(std::max_align_t)
+
+static std::size_t align_command(std::size_t size)
+{
+    return (size + COMMAND_ALIGNMENT - 1) & ~(COMMAND_ALIGNMENT - 1);
+}
+
+struct CommandHeader {
+    GL::CommandType type;
+    // Of the whole command, header included
+    std::uint32_t size;
+};
+
+struct BindShaderCommand {
+    const GL::Shader* shader;
+};
+
+struct BindTextureCommand {
+    const GL::Texture* texture;
+    GLuint slot;
+};
+
+struct BindVertexArrayCommand {
+    const GL::VertexArray* vertex_array;
+};
+
+// The uniform name follows the payload
+struct UniformCommand {
+    GL::Shader* shader;
+    float values[4];
+    int integer;
+    std::uint32_t name_size;
+};
+
+// The vertex data follows the payload
+struct PushVerticesCommand {
+    GL::VertexBuffer* vertex_buffer;
+    std::size_t count;
+    std::size_t size;
+};
+
+struct DrawElementsCommand {
+    const GL::IndexBuffer* index_buffer;
+    GLenum mode;
+    GLint base_vertex;
+    std::size_t first_index;
+    std::size_t index_count;
+};
+
+struct ClearCommand {
+    GLbitfield mask;
+};
+
+#define HEADER_SIZE align_command(sizeof(CommandHeader))
+
+namespace GL {
+
+CommandBuffer::CommandBuffer(std::size_t capacity)
+    : m_arena(capacity)
+{
+}
+
+template <typename T>
+T* CommandBuffer::push(CommandType type, std::size_t extra_size)
+{
+    std::size_t size = HEADER_SIZE + align_command(sizeof(T) + extra_size);
+
+    if (m_size + size > m_arena.size()) {
+        m_arena.resize(std::max(m_arena.size() * 2, m_size + size));
+    }
+
+    CommandHeader* header = reinterpret_cast<CommandHeader*>(m_arena.data() + m_size);
+    header->type = type;
+    header->size = size;
+
+    T* payload = reinterpret_cast<T*>(m_arena.data() + m_size + HEADER_SIZE);
+
+    m_size += size;
+    m_command_count += 1;
+
+    return payload;
+}
+
+void CommandBuffer::bind_shader(const Shader& shader)
+{
+    push<BindShaderCommand>(CommandType::BIND_SHADER)->shader = &shader;
+}
+
+void CommandBuffer::bind_texture(const Texture& texture, GLuint slot)
+{
+    BindTextureCommand* command = push<BindTextureCommand>(CommandType::BIND_TEXTURE);
+    command->texture = &texture;
+    command->slot = slot;
+}
+
+void CommandBuffer::bind_vertex_array(const VertexArray& vertex_array)
+{
+    push<BindVertexArrayCommand>(CommandType::BIND_VERTEX_ARRAY)->vertex_array = &vertex_array;
+    m_vertex_array_bound = true;
+}
+
+void CommandBuffer::set_uniform(Shader& shader, std::string_view name, int x)
+{
+    UniformCommand* command = push<UniformCommand>(CommandType::UNIFORM_INT, name.size());
+    command->shader = &shader;
+    command->integer = x;
+    command->name_size = name.size();
+    std::memcpy(command + 1, name.data(), name.size());
+}
+
+void CommandBuffer::set_uniform(Shader& shader, std::string_view name,
+                                float x, float y, float z)
+{
+    UniformCommand* command = push<UniformCommand>(CommandType::UNIFORM_VEC3, name.size());
+    command->shader = &shader;
+    command->values[0] = x;
+    command->values[1] = y;
+    command->values[2] = z;
+    command->name_size = name.size();
+    std::memcpy(command + 1, name.data(), name.size());
+}
+
+void CommandBuffer::set_uniform(Shader& shader, std::string_view name,
+                                float x, float y, float z, float w)
+{
+    UniformCommand* command = push<UniformCommand>(CommandType::UNIFORM_VEC4, name.size());
+    command->shader = &shader;
+    command->values[0] = x;
+    command->values[1] = y;
+    command->values[2] = z;
+    command->values[3] = w;
+    command->name_size = name.size();
+    std::memcpy(command + 1, name.data(), name.size());
+}
+
+void CommandBuffer::push_vertices(VertexBuffer& vertex_buffer, const void* data,
+                                  std::size_t count)
+{
+    std::size_t size = count * vertex_buffer.layout().stride;
+
+    PushVerticesCommand* command = push<PushVerticesCommand>(CommandType::PUSH_VERTICES, size);
+    command->vertex_buffer = &vertex_buffer;
+    command->count = count;
+    command->size = size;
+    std::memcpy(command + 1, data, size);
+}
+
+void CommandBuffer::draw(const IndexBuffer& index_buffer, GLenum mode,
+                         std::size_t first_index, std::size_t index_count,
+                         GLint base_vertex)
+{
+    if (!m_vertex_array_bound) {
+        std::cerr << "ERROR: CommandBuffer: draw recorded before binding a vertex array, it is dropped\n";
+        return;
+    }
+
+    DrawElementsCommand* command = push<DrawElementsCommand>(CommandType::DRAW_ELEMENTS);
+    command->index_buffer = &index_buffer;
+    command->mode = mode;
+    command->base_vertex = base_vertex;
+    command->first_index = first_index;
+    command->index_count = index_count;
+}
+
+void CommandBuffer::clear(GLbitfield mask)
+{
+    push<ClearCommand>(CommandType::CLEAR)->mask = mask;
+}
+
+void CommandBuffer::execute() const
+{
+    trace_scope("CommandBuffer::execute");
+
+    std::size_t position = 0;
+
+    while (position < m_size) {
+        const CommandHeader* header = reinterpret_cast<const CommandHeader*>(m_arena.data() + position);
+        const unsigned char* payload = m_arena.data() + position + HEADER_SIZE;
+        position += header->size;
+
+        switch (header->type) {
+
+        case CommandType::BIND_SHADER: {
+            reinterpret_cast<const BindShaderCommand*>(payload)->shader->bind();
+            break;
+        }
+
+        case CommandType::BIND_TEXTURE: {
+            auto command = reinterpret_cast<const BindTextureCommand*>(payload);
+            command->texture->bind(command->slot);
+            break;
+        }
+
+        case CommandType::BIND_VERTEX_ARRAY: {
+            reinterpret_cast<const BindVertexArrayCommand*>(payload)->vertex_array->bind();
+            break;
+        }
+
+        case CommandType::UNIFORM_INT:
+        case CommandType::UNIFORM_VEC3:
+        case CommandType::UNIFORM_VEC4: {
+            auto command = reinterpret_cast<const UniformCommand*>(payload);
+            std::string_view name(reinterpret_cast<const char*>(command + 1), command->name_size);
+            const float* v = command->values;
+
+            if (header->type == CommandType::UNIFORM_INT)
+                command->shader->set_uniform(name, command->integer);
+            else if (header->type == CommandType::UNIFORM_VEC3)
+                command->shader->set_uniform(name, v[0], v[1], v[2]);
+            else
+                command->shader->set_uniform(name, v[0], v[1], v[2], v[3]);
+            break;
+        }
+
+        case CommandType::PUSH_VERTICES: {
+            auto command = reinterpret_cast<const PushVerticesCommand*>(payload);
+            command->vertex_buffer->bind();
+            command->vertex_buffer->push_vertices(command + 1, command->count);
+            break;
+        }
+
+        case CommandType::DRAW_ELEMENTS: {
+            auto command = reinterpret_cast<const DrawElementsCommand*>(payload);
+            command->index_buffer->draw(command->mode, command->first_index,
+                                        command->index_count, command->base_vertex);
+            break;
+        }
+
+        case CommandType::CLEAR: {
+            gl(Clear, (reinterpret_cast<const ClearCommand*>(payload)->mask));
+            break;
+        }
+        }
+    }
+}
+
+void CommandBuffer::reset()
+{
+    m_size = 0;
+    m_command_count = 0;
+    m_vertex_array_bound = false;
+}
+
+}
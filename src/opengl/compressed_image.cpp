@@ -0,0 +1,253 @@
+#include "opengl/compressed_image.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "opengl/image.hpp"
+
+static const unsigned char dds_magic[4] = { 'D', 'D', 'S', ' ' };
+static const unsigned char ktx2_magic[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+#define DDS_HEADER_SIZE 124
+#define DDS_DX10_HEADER_SIZE 20
+
+#define KTX2_HEADER_SIZE 80
+#define KTX2_LEVEL_INDEX_ENTRY_SIZE 24
+
+struct Bytes {
+    const unsigned char* data;
+    std::size_t size;
+};
+
+template <typename T>
+static bool read_le(Bytes bytes, std::size_t offset, T& value)
+{
+    if (offset + sizeof(T) > bytes.size)
+        return false;
+
+    std::memcpy(&value, bytes.data + offset, sizeof(T));
+    return true;
+}
+
+static std::uint32_t fourcc(const char* code)
+{
+    return code[0] | code[1] << 8 | code[2] << 16 | code[3] << 24;
+}
+
+static bool dds_pixel_format(Bytes bytes,
+                             GL::PixelFormat& format, std::size_t& data_offset)
+{
+    std::uint32_t code;
+    if (!read_le(bytes, 4 + 80, code))
+        return false;
+
+    data_offset = sizeof(dds_magic) + DDS_HEADER_SIZE;
+
+    if (code == fourcc("DXT1")) {
+        format = GL::PixelFormat::BC1_RGBA;
+        return true;
+    }
+
+    if (code == fourcc("DXT5")) {
+        format = GL::PixelFormat::BC3_RGBA;
+        return true;
+    }
+
+    if (code != fourcc("DX10"))
+        return false;
+
+    std::uint32_t dxgi_format;
+    if (!read_le(bytes, data_offset, dxgi_format))
+        return false;
+
+    data_offset += DDS_DX10_HEADER_SIZE;
+
+    switch (dxgi_format) {
+
+    case 71: // DXGI_FORMAT_BC1_UNORM
+        format = GL::PixelFormat::BC1_RGBA;
+        return true;
+    case 77: // DXGI_FORMAT_BC3_UNORM
+        format = GL::PixelFormat::BC3_RGBA;
+        return true;
+    case 98: // DXGI_FORMAT_BC7_UNORM
+        format = GL::PixelFormat::BC7_RGBA;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static bool parse_dds(Bytes bytes, GL::PixelFormat& format,
+                      std::vector<GL::TextureLevel>& levels)
+{
+    std::uint32_t height;
+    std::uint32_t width;
+    std::uint32_t level_count;
+
+    if (!read_le(bytes, 4 + 8, height)
+        || !read_le(bytes, 4 + 12, width)
+        || !read_le(bytes, 4 + 24, level_count))
+        return false;
+
+    std::size_t offset;
+    if (!dds_pixel_format(bytes, format, offset)) {
+        std::cerr << "ERROR: unsupported DDS pixel format\n";
+        return false;
+    }
+
+    // Files without DDSD_MIPMAPCOUNT leave the count at 0
+    level_count = std::max<std::uint32_t>(1, level_count);
+
+    for (std::uint32_t i = 0; i < level_count; ++i) {
+        std::size_t level_width = std::max<std::size_t>(1, width >> i);
+        std::size_t level_height = std::max<std::size_t>(1, height >> i);
+        std::size_t size = GL::level_size(format, level_width, level_height);
+
+        if (size > bytes.size || offset > bytes.size - size)
+            return false;
+
+        levels.push_back({
+            .data = bytes.data + offset,
+            .size = size,
+            .width = level_width,
+            .height = level_height,
+        });
+
+        offset += size;
+    }
+
+    return true;
+}
+
+static bool ktx2_pixel_format(std::uint32_t vk_format, GL::PixelFormat& format)
+{
+    switch (vk_format) {
+
+    case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+        format = GL::PixelFormat::BC1_RGBA;
+        return true;
+    case 137: // VK_FORMAT_BC3_UNORM_BLOCK
+        format = GL::PixelFormat::BC3_RGBA;
+        return true;
+    case 145: // VK_FORMAT_BC7_UNORM_BLOCK
+        format = GL::PixelFormat::BC7_RGBA;
+        return true;
+    case 151: // VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+        format = GL::PixelFormat::ETC2_RGBA8;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+static bool parse_ktx2(Bytes bytes, GL::PixelFormat& format,
+                       std::vector<GL::TextureLevel>& levels)
+{
+    std::uint32_t vk_format;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t level_count;
+    std::uint32_t supercompression_scheme;
+
+    if (!read_le(bytes, 12, vk_format)
+        || !read_le(bytes, 20, width)
+        || !read_le(bytes, 24, height)
+        || !read_le(bytes, 40, level_count)
+        || !read_le(bytes, 44, supercompression_scheme))
+        return false;
+
+    if (!ktx2_pixel_format(vk_format, format)) {
+        std::cerr << "ERROR: unsupported KTX2 format " << vk_format << "\n";
+        return false;
+    }
+
+    if (supercompression_scheme != 0) {
+        std::cerr << "ERROR: supercompressed KTX2 files are not supported\n";
+        return false;
+    }
+
+    level_count = std::max<std::uint32_t>(1, level_count);
+
+    for (std::uint32_t i = 0; i < level_count; ++i) {
+        std::size_t entry = KTX2_HEADER_SIZE + i * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+
+        std::uint64_t offset;
+        std::uint64_t size;
+        if (!read_le(bytes, entry, offset) || !read_le(bytes, entry + 8, size))
+            return false;
+
+        if (size > bytes.size || offset > bytes.size - size)
+            return false;
+
+        std::size_t level_width = std::max<std::size_t>(1, width >> i);
+        std::size_t level_height = std::max<std::size_t>(1, height >> i);
+
+        // Levels may hold several layers or faces, only the first one is used
+        std::size_t first_image_size = GL::level_size(format, level_width, level_height);
+        if (first_image_size > size)
+            return false;
+
+        levels.push_back({
+            .data = bytes.data + offset,
+            .size = first_image_size,
+            .width = level_width,
+            .height = level_height,
+        });
+    }
+
+    return true;
+}
+
+static bool has_magic(Bytes bytes, const unsigned char* magic, std::size_t magic_size)
+{
+    return bytes.size >= magic_size && std::memcmp(bytes.data, magic, magic_size) == 0;
+}
+
+namespace GL {
+
+bool parse_compressed_image(const unsigned char* data, std::size_t size,
+                            PixelFormat& format, std::vector<TextureLevel>& levels)
+{
+    Bytes bytes = { .data = data, .size = size };
+
+    bool parsed = false;
+
+    if (has_magic(bytes, dds_magic, sizeof(dds_magic))) {
+        parsed = parse_dds(bytes, format, levels);
+    } else if (has_magic(bytes, ktx2_magic, sizeof(ktx2_magic))) {
+        parsed = parse_ktx2(bytes, format, levels);
+    } else {
+        std::cerr << "ERROR: not a DDS or KTX2 file\n";
+        return false;
+    }
+
+    if (!parsed)
+        levels.clear();
+
+    return parsed;
+}
+
+CompressedImage load_compressed_image(const std::string& path)
+{
+    CompressedImage image;
+
+    if (!read_file(path, image.bytes))
+        return CompressedImage();
+
+    if (!parse_compressed_image(image.bytes.data(), image.bytes.size(),
+                                image.format, image.levels)) {
+        std::cerr << "ERROR: could not load compressed image `" << path << "`\n";
+        return CompressedImage();
+    }
+
+    return image;
+}
+
+}
@@ -0,0 +1,76 @@
+#include "opengl/compute_shader.hpp"
+
+#include <iostream>
+
+#include "opengl/gl_errors.hpp"
+
+namespace GL {
+
+ComputeShader::ComputeShader(const std::string& path)
+    : Shader(path)
+{
+    check_compute_stage();
+}
+
+ComputeShader::ComputeShader(const std::string& name, std::string_view source)
+    : Shader(name, source)
+{
+    check_compute_stage();
+}
+
+void ComputeShader::check_compute_stage()
+{
+    if (!m_valid)
+        return;
+
+    // Compute stages can not be combined with other stages, so the first
+    // attached shader tells the kind of program
+    GLuint shader = 0;
+    GLsizei shader_count = 0;
+    gl(GetAttachedShaders, (m_id, 1, &shader_count, &shader));
+
+    GLint type = 0;
+    if (shader_count > 0) {
+        gl(GetShaderiv, (shader, GL_SHADER_TYPE, &type));
+    }
+
+    if (type != GL_COMPUTE_SHADER) {
+        std::cerr << m_name << ": ERROR: compute shader has no compute stage\n";
+        m_valid = false;
+    }
+}
+
+void ComputeShader::local_size(GLint size[3]) const
+{
+    gl(GetProgramiv, (m_id, GL_COMPUTE_WORK_GROUP_SIZE, size));
+}
+
+void ComputeShader::dispatch(GLuint x, GLuint y, GLuint z)
+{
+    bind();
+    gl(DispatchCompute, (x, y, z));
+}
+
+void ComputeShader::dispatch_items(std::size_t count)
+{
+    if (count == 0)
+        return;
+
+    GLint size[3];
+    local_size(size);
+
+    dispatch((count + size[0] - 1) / size[0]);
+}
+
+void memory_barrier(GLbitfield barriers)
+{
+    gl(MemoryBarrier, (barriers));
+}
+
+bool is_compute_supported()
+{
+    return GLEW_VERSION_4_3
+        || (GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object);
+}
+
+}
@@ -0,0 +1,87 @@
+#include "opengl/context.hpp"
+
+#include <iostream>
+
+#include "opengl/gl_errors.hpp"
+
+namespace GL {
+
+#ifndef OPENGL_HAS_GLFW
+Context* create_glfw_context(const ContextConfig& config)
+{
+    (void)config;
+
+    std::cerr << "ERROR: the library was built without GLFW, no window can be created\n";
+    return nullptr;
+}
+#endif
+
+#ifndef OPENGL_HAS_EGL
+Context* create_egl_context(const ContextConfig& config)
+{
+    (void)config;
+
+    std::cerr << "ERROR: the library was built without EGL, no headless context can be created\n";
+    return nullptr;
+}
+#endif
+
+void Context::read_pixels(std::vector<unsigned char>& pixels) const
+{
+    pixels.resize(m_width * m_height * 4);
+
+    gl(BindFramebuffer, (GL_READ_FRAMEBUFFER, framebuffer()));
+    gl(PixelStorei, (GL_PACK_ALIGNMENT, 1));
+    gl(ReadPixels, (0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+    gl(PixelStorei, (GL_PACK_ALIGNMENT, 4));
+}
+
+Context* create_context(const ContextConfig& config)
+{
+    Context* context = config.headless
+        ? create_egl_context(config)
+        : create_glfw_context(config);
+    if (context == nullptr)
+        return nullptr;
+
+    // Core profiles need the experimental path to load every entry point
+    glewExperimental = GL_TRUE;
+    GLenum result = glewInit();
+
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLEW built for GLX fails its GLX part without an X display, the GL
+    // entry points are loaded by then
+    if (result == GLEW_ERROR_NO_GLX_DISPLAY)
+        result = GLEW_OK;
+#endif
+
+    if (result != GLEW_OK) {
+        std::cerr << "ERROR: could not load OpenGL\n";
+        std::cerr << "    > GLEW initialization failed!\n";
+        delete context;
+        return nullptr;
+    }
+
+    // glewExperimental may leave an invalid enum error behind
+    clear_errors();
+
+    if (!context->init_gl()) {
+        delete context;
+        return nullptr;
+    }
+
+    GLint major_version = 0;
+    GLint minor_version = 0;
+    gl_fn(GetIntegerv)(GL_MAJOR_VERSION, &major_version);
+    gl_fn(GetIntegerv)(GL_MINOR_VERSION, &minor_version);
+
+    std::cout << "[INFO] Context version: OpenGL "
+              << major_version << "." << minor_version
+              << (context->is_headless() ? " (headless)" : "")
+              << ", renderer " << gl_fn(GetString)(GL_RENDERER)
+              << "\n";
+
+    return context;
+}
+
+}
@@ -0,0 +1,205 @@
+#include "opengl/context.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "opengl/gl_errors.hpp"
+
+static bool has_extension(const char* extensions, const char* name)
+{
+    if (extensions == nullptr)
+        return false;
+
+    std::size_t length = std::strlen(name);
+    for (const char* it = std::strstr(extensions, name); it != nullptr; it = std::strstr(it + 1, name)) {
+        bool starts = it == extensions || it[-1] == ' ';
+        bool ends = it[length] == ' ' || it[length] == '\0';
+        if (starts && ends)
+            return true;
+    }
+
+    return false;
+}
+
+namespace GL {
+
+// A context without any window, on Mesa's surfaceless platform when
+// available so that no display server is needed either. Drawing goes to a
+// framebuffer object of the configured size.
+class EglContext : public Context {
+private:
+    EGLDisplay m_display = EGL_NO_DISPLAY;
+    EGLContext m_context = EGL_NO_CONTEXT;
+    EGLSurface m_surface = EGL_NO_SURFACE;
+
+    GLuint m_framebuffer = 0;
+    GLuint m_color_buffer = 0;
+    GLuint m_depth_buffer = 0;
+
+public:
+    EglContext(const ContextConfig& config);
+    ~EglContext();
+
+    EglContext(const EglContext&) = delete;
+    EglContext& operator=(const EglContext&) = delete;
+
+    bool is_valid() const { return m_context != EGL_NO_CONTEXT; }
+
+    bool init_gl() override;
+
+    bool is_headless() const override { return true; }
+    bool should_close() const override { return false; }
+    void swap_buffers() override;
+    void poll_events() override { }
+    GLuint framebuffer() const override { return m_framebuffer; }
+};
+
+EglContext::EglContext(const ContextConfig& config)
+{
+    m_width = config.width;
+    m_height = config.height;
+
+    const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+        auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+        if (get_platform_display != nullptr)
+            m_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (m_display == EGL_NO_DISPLAY)
+        m_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major, minor;
+    if (m_display == EGL_NO_DISPLAY || !eglInitialize(m_display, &major, &minor)) {
+        std::cerr << "ERROR: EGL: could not initialize a display\n";
+        m_display = EGL_NO_DISPLAY;
+        return;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "ERROR: EGL: desktop OpenGL is not supported\n";
+        return;
+    }
+
+    bool surfaceless = has_extension(eglQueryString(m_display, EGL_EXTENSIONS),
+                                     "EGL_KHR_surfaceless_context");
+
+    EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, surfaceless ? EGL_DONT_CARE : EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+
+    EGLConfig egl_config;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(m_display, config_attributes, &egl_config, 1, &config_count) || config_count == 0) {
+        std::cerr << "ERROR: EGL: no suitable config\n";
+        return;
+    }
+
+    EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION_KHR, config.major_version,
+        EGL_CONTEXT_MINOR_VERSION_KHR, config.minor_version,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+        EGL_NONE
+    };
+
+    m_context = eglCreateContext(m_display, egl_config, EGL_NO_CONTEXT, context_attributes);
+    if (m_context == EGL_NO_CONTEXT) {
+        std::cerr << "ERROR: EGL: could not create an OpenGL "
+                  << config.major_version << "." << config.minor_version << " context\n";
+        return;
+    }
+
+    if (!surfaceless) {
+        EGLint surface_attributes[] = {
+            EGL_WIDTH, static_cast<EGLint>(m_width),
+            EGL_HEIGHT, static_cast<EGLint>(m_height),
+            EGL_NONE
+        };
+        m_surface = eglCreatePbufferSurface(m_display, egl_config, surface_attributes);
+    }
+
+    if (!eglMakeCurrent(m_display, m_surface, m_surface, m_context)) {
+        std::cerr << "ERROR: EGL: could not make the context current\n";
+        eglDestroyContext(m_display, m_context);
+        m_context = EGL_NO_CONTEXT;
+    }
+}
+
+EglContext::~EglContext()
+{
+    if (m_framebuffer != 0) {
+        gl(DeleteFramebuffers, (1, &m_framebuffer));
+        gl(DeleteRenderbuffers, (1, &m_color_buffer));
+        gl(DeleteRenderbuffers, (1, &m_depth_buffer));
+    }
+
+    if (m_display == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (m_surface != EGL_NO_SURFACE)
+        eglDestroySurface(m_display, m_surface);
+    if (m_context != EGL_NO_CONTEXT)
+        eglDestroyContext(m_display, m_context);
+    eglTerminate(m_display);
+}
+
+bool EglContext::init_gl()
+{
+    gl(GenRenderbuffers, (1, &m_color_buffer));
+    gl(BindRenderbuffer, (GL_RENDERBUFFER, m_color_buffer));
+    gl(RenderbufferStorage, (GL_RENDERBUFFER, GL_RGBA8, m_width, m_height));
+
+    gl(GenRenderbuffers, (1, &m_depth_buffer));
+    gl(BindRenderbuffer, (GL_RENDERBUFFER, m_depth_buffer));
+    gl(RenderbufferStorage, (GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height));
+    gl(BindRenderbuffer, (GL_RENDERBUFFER, 0));
+
+    gl(GenFramebuffers, (1, &m_framebuffer));
+    gl(BindFramebuffer, (GL_FRAMEBUFFER, m_framebuffer));
+    gl(FramebufferRenderbuffer, (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_color_buffer));
+    gl(FramebufferRenderbuffer, (GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depth_buffer));
+
+    GLenum status;
+    gl_call(status = gl_fn(CheckFramebufferStatus)(GL_FRAMEBUFFER));
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR: EGL: offscreen framebuffer is incomplete, status 0x"
+                  << std::hex << status << std::dec << "\n";
+        return false;
+    }
+
+    // The framebuffer stays bound, it stands in for the window
+    gl(Viewport, (0, 0, m_width, m_height));
+
+    return true;
+}
+
+void EglContext::swap_buffers()
+{
+    // Nothing is presented, but frames should still reach the GPU
+    gl(Flush, ());
+    flush_gl_errors();
+}
+
+Context* create_egl_context(const ContextConfig& config)
+{
+    EglContext* context = new EglContext(config);
+    if (!context->is_valid()) {
+        delete context;
+        return nullptr;
+    }
+
+    return context;
+}
+
+}
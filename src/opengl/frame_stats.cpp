@@ -0,0 +1,77 @@
+#include "opengl/frame_stats.hpp"
+
+#include <iostream>
+
+static GL::FrameStats current_frame;
+static GL::FrameStats last_frame;
+
+namespace GL {
+
+const char* flush_reason_name(FlushReason reason)
+{
+    switch (reason) {
+
+    case FlushReason::BLEND:
+        return "blend";
+    case FlushReason::SHADER:
+        return "shader";
+    case FlushReason::TEXTURE:
+        return "texture";
+    case FlushReason::GEOMETRY:
+        return "geometry";
+    case FlushReason::END:
+        return "end";
+
+    default:
+        return "unknown";
+    }
+}
+
+std::size_t FrameStats::flush_count() const
+{
+    std::size_t count = 0;
+    for (std::size_t flushes_for_reason : flushes)
+        count += flushes_for_reason;
+
+    return count;
+}
+
+FrameStats& frame_stats()
+{
+    return current_frame;
+}
+
+void end_frame_stats()
+{
+    last_frame = current_frame;
+    current_frame = FrameStats();
+}
+
+const FrameStats& last_frame_stats()
+{
+    return last_frame;
+}
+
+void print_frame_stats(std::ostream& out, const FrameStats& stats)
+{
+    out << "    draw calls:        " << stats.draw_calls << "\n"
+        << "    vertices:          " << stats.vertices << "\n"
+        << "    indices:           " << stats.indices << " pushed, "
+        << stats.indices_drawn << " drawn\n"
+        << "    buffer uploads:    " << stats.buffer_bytes_uploaded << " bytes, "
+        << stats.buffer_reallocations << " reallocations\n"
+        << "    texture binds:     " << stats.texture_binds << "\n"
+        << "    program binds:     " << stats.program_binds << "\n"
+        << "    uniform uploads:   " << stats.uniform_uploads << " issued, "
+        << stats.uniform_uploads_skipped << " skipped\n"
+        << "    flushes:           " << stats.flush_count();
+
+    for (std::size_t i = 0; i < static_cast<std::size_t>(FlushReason::COUNT); ++i) {
+        if (stats.flushes[i] != 0)
+            out << ", " << stats.flushes[i] << " " << flush_reason_name(static_cast<FlushReason>(i));
+    }
+
+    out << "\n";
+}
+
+}
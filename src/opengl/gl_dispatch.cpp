@@ -0,0 +1,353 @@
+#include "opengl/gl_dispatch.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "opengl/gl_stats.hpp"
+
+/*                        *
+ *   GLEW                 *
+ *                        */
+
+// GLEW's entry points are only loaded by glewInit(), so the table holds
+// wrappers that read them at call time
+#define GL_FUNCTION(name, return_type, params, args, kind) \
+    static return_type glew_##name params { return gl##name args; }
+GL_FUNCTIONS
+#undef GL_FUNCTION
+
+static constexpr GL::GLDispatchTable glew_table = {
+#define GL_FUNCTION(name, return_type, params, args, kind) .name = glew_##name,
+    GL_FUNCTIONS
+#undef GL_FUNCTION
+};
+
+/*                        *
+ *   Recording            *
+ *                        */
+
+enum class CallKind {
+    CALL,
+    STATE,
+    BIND,
+    UNIFORM,
+    UPLOAD,
+    DRAW,
+};
+
+static const CallKind call_kinds[] = {
+#define GL_FUNCTION(name, return_type, params, args, kind) CallKind::kind,
+    GL_FUNCTIONS
+#undef GL_FUNCTION
+};
+
+static const char* function_names[] = {
+#define GL_FUNCTION(name, return_type, params, args, kind) "gl" #name,
+    GL_FUNCTIONS
+#undef GL_FUNCTION
+};
+
+static GL::GLRecording recording;
+static std::ostream* recording_log = nullptr;
+
+static GLuint next_name = 0;
+static std::unordered_map<GLuint, GLenum> shader_types;
+static std::unordered_map<GLuint, std::vector<GLuint>> attached_shaders;
+static std::vector<unsigned char> mapped_buffer;
+
+static void record(GL::GLFunction function)
+{
+    std::size_t index = static_cast<std::size_t>(function);
+
+    recording.calls += 1;
+    recording.counts[index] += 1;
+
+    switch (call_kinds[index]) {
+    case CallKind::CALL:
+        break;
+    case CallKind::STATE:
+    case CallKind::BIND:
+        recording.state_changes += 1;
+        break;
+    case CallKind::UNIFORM:
+        recording.uniform_uploads += 1;
+        break;
+    case CallKind::UPLOAD:
+        break;
+    case CallKind::DRAW:
+        recording.draw_calls += 1;
+        break;
+    }
+
+    if (recording_log != nullptr)
+        *recording_log << function_names[index] << "\n";
+}
+
+template<typename T>
+static T default_result()
+{
+    if constexpr (std::is_void_v<T>)
+        return;
+    else
+        return T {};
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+// Uploads are sized the same way as with the `gl_stats` option
+#define GL_RECORD_BYTES_CALL(name, args)
+#define GL_RECORD_BYTES_STATE GL_RECORD_BYTES_CALL
+#define GL_RECORD_BYTES_UNIFORM GL_RECORD_BYTES_CALL
+#define GL_RECORD_BYTES_DRAW GL_RECORD_BYTES_CALL
+#define GL_RECORD_BYTES_UPLOAD(name, args) \
+    recording.bytes_uploaded += GL::gl_upload_size_##name args;
+#define GL_RECORD_BYTES_BIND GL_RECORD_BYTES_UPLOAD
+
+#define GL_FUNCTION(name, return_type, params, args, kind) \
+    static return_type record_##name params                \
+    {                                                      \
+        record(GL::GLFunction::name);                      \
+        GL_RECORD_BYTES_##kind(name, args)                 \
+        return default_result<return_type>();              \
+    }
+GL_FUNCTIONS
+#undef GL_FUNCTION
+
+template<GL::GLFunction function>
+static void record_gen(GLsizei n, GLuint* names)
+{
+    record(function);
+
+    for (GLsizei i = 0; i < n; ++i)
+        names[i] = ++next_name;
+}
+
+static GLuint record_create_program()
+{
+    record(GL::GLFunction::CreateProgram);
+    return ++next_name;
+}
+
+static GLuint record_create_shader(GLenum type)
+{
+    record(GL::GLFunction::CreateShader);
+
+    GLuint shader = ++next_name;
+    shader_types[shader] = type;
+    return shader;
+}
+
+static void record_attach_shader(GLuint program, GLuint shader)
+{
+    record(GL::GLFunction::AttachShader);
+    attached_shaders[program].push_back(shader);
+}
+
+static void record_get_attached_shaders(GLuint program, GLsizei max_count, GLsizei* count, GLuint* shaders)
+{
+    record(GL::GLFunction::GetAttachedShaders);
+
+    const std::vector<GLuint>& attached = attached_shaders[program];
+    GLsizei written = 0;
+    for (; written < max_count && written < GLsizei(attached.size()); ++written)
+        shaders[written] = attached[written];
+
+    if (count != nullptr)
+        *count = written;
+}
+
+// Every build succeeds and leaves no log
+static void write_status(GLenum pname, GLint* params)
+{
+    switch (pname) {
+    case GL_COMPILE_STATUS:
+    case GL_LINK_STATUS:
+    case GL_VALIDATE_STATUS:
+    case GL_COMPLETION_STATUS_KHR:
+        *params = GL_TRUE;
+        break;
+    case GL_COMPUTE_WORK_GROUP_SIZE:
+        params[0] = 1;
+        params[1] = 1;
+        params[2] = 1;
+        break;
+    default:
+        *params = 0;
+        break;
+    }
+}
+
+static void record_get_shader_iv(GLuint shader, GLenum pname, GLint* params)
+{
+    record(GL::GLFunction::GetShaderiv);
+
+    if (pname == GL_SHADER_TYPE)
+        *params = shader_types[shader];
+    else
+        write_status(pname, params);
+}
+
+static void record_get_program_iv(GLuint program, GLenum pname, GLint* params)
+{
+    record(GL::GLFunction::GetProgramiv);
+    write_status(pname, params);
+}
+
+static void record_get_integer_v(GLenum pname, GLint* data)
+{
+    record(GL::GLFunction::GetIntegerv);
+    *data = 0;
+}
+
+static void record_get_integer_64v(GLenum pname, GLint64* data)
+{
+    record(GL::GLFunction::GetInteger64v);
+    *data = 0;
+}
+
+static const GLubyte* record_get_string(GLenum name)
+{
+    record(GL::GLFunction::GetString);
+    return reinterpret_cast<const GLubyte*>("recording");
+}
+
+static GLenum record_check_framebuffer_status(GLenum target)
+{
+    record(GL::GLFunction::CheckFramebufferStatus);
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static GLsync record_fence_sync(GLenum condition, GLbitfield flags)
+{
+    record(GL::GLFunction::FenceSync);
+    return reinterpret_cast<GLsync>(std::uintptr_t(++next_name));
+}
+
+static GLenum record_client_wait_sync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+{
+    record(GL::GLFunction::ClientWaitSync);
+    return GL_ALREADY_SIGNALED;
+}
+
+static void* record_map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+    record(GL::GLFunction::MapBufferRange);
+
+    mapped_buffer.resize(length);
+    return mapped_buffer.data();
+}
+
+// Whatever was written to the mapping is uploaded when it is unmapped
+static GLboolean record_unmap_buffer(GLenum target)
+{
+    record(GL::GLFunction::UnmapBuffer);
+
+    recording.bytes_uploaded += mapped_buffer.size();
+    mapped_buffer.clear();
+    return GL_TRUE;
+}
+
+static void record_get_buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, void* data)
+{
+    record(GL::GLFunction::GetBufferSubData);
+    std::memset(data, 0, size);
+}
+
+// Query results are available right away and measure nothing
+static void record_get_query_object_iv(GLuint id, GLenum pname, GLint* params)
+{
+    record(GL::GLFunction::GetQueryObjectiv);
+    *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+}
+
+static void record_get_query_object_ui64v(GLuint id, GLenum pname, GLuint64* params)
+{
+    record(GL::GLFunction::GetQueryObjectui64v);
+    *params = 0;
+}
+
+#pragma GCC diagnostic pop
+
+static GL::GLDispatchTable make_recording_table()
+{
+    GL::GLDispatchTable table = {
+#define GL_FUNCTION(name, return_type, params, args, kind) .name = record_##name,
+        GL_FUNCTIONS
+#undef GL_FUNCTION
+    };
+
+    table.GenBuffers = record_gen<GL::GLFunction::GenBuffers>;
+    table.GenFramebuffers = record_gen<GL::GLFunction::GenFramebuffers>;
+    table.GenQueries = record_gen<GL::GLFunction::GenQueries>;
+    table.GenRenderbuffers = record_gen<GL::GLFunction::GenRenderbuffers>;
+    table.GenTextures = record_gen<GL::GLFunction::GenTextures>;
+    table.GenVertexArrays = record_gen<GL::GLFunction::GenVertexArrays>;
+    table.CreateProgram = record_create_program;
+    table.CreateShader = record_create_shader;
+    table.AttachShader = record_attach_shader;
+    table.GetAttachedShaders = record_get_attached_shaders;
+    table.GetShaderiv = record_get_shader_iv;
+    table.GetProgramiv = record_get_program_iv;
+    table.GetIntegerv = record_get_integer_v;
+    table.GetInteger64v = record_get_integer_64v;
+    table.GetString = record_get_string;
+    table.CheckFramebufferStatus = record_check_framebuffer_status;
+    table.FenceSync = record_fence_sync;
+    table.ClientWaitSync = record_client_wait_sync;
+    table.MapBufferRange = record_map_buffer_range;
+    table.UnmapBuffer = record_unmap_buffer;
+    table.GetBufferSubData = record_get_buffer_sub_data;
+    table.GetQueryObjectiv = record_get_query_object_iv;
+    table.GetQueryObjectui64v = record_get_query_object_ui64v;
+
+    return table;
+}
+
+namespace GL {
+
+GLDispatchTable gl_dispatch = glew_table;
+
+static GLBackend current_backend = GLBackend::GLEW;
+
+const char* gl_function_name(GLFunction function)
+{
+    return function_names[static_cast<std::size_t>(function)];
+}
+
+void set_gl_backend(GLBackend backend)
+{
+#ifndef OPENGL_GL_DISPATCH
+    if (backend != GLBackend::GLEW)
+        std::cerr << "ERROR: the library was built without the gl_dispatch option, GL calls are not recorded\n";
+#endif
+
+    current_backend = backend;
+    gl_dispatch = backend == GLBackend::RECORDING ? make_recording_table() : glew_table;
+}
+
+GLBackend gl_backend()
+{
+    return current_backend;
+}
+
+const GLRecording& gl_recording()
+{
+    return recording;
+}
+
+void reset_gl_recording()
+{
+    recording = GLRecording();
+}
+
+void set_gl_recording_log(std::ostream* log)
+{
+    recording_log = log;
+}
+
+}
@@ -1,24 +1,328 @@
 #include "opengl/gl_errors.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <tuple>
 
 #include <GL/glew.h>
 
+// Errors queued between two drains, more are dropped and counted
+#define GL_ERROR_RING_SIZE 1024
+
+// Repeats of an error at the same call site are summed up at most this
+// often, the first one is always written
+#define GL_ERROR_REPORT_INTERVAL std::chrono::seconds(1)
+
+// Back to back repeats of an error are queued as one entry of up to this
+// many errors, so that a storm does not fill the ring
+#define GL_ERROR_COALESCE_LIMIT 4096
+
+struct GLErrorSlot {
+    // Equals the write position once the slot is written, and the write
+    // position of the next lap once it is read
+    std::atomic<std::size_t> sequence;
+    const char* file;
+    int line;
+    GLenum error;
+    std::size_t count;
+};
+
+// Bounded multi producer ring, any thread with a context can queue errors
+// without taking a lock. Only `flush_gl_errors()` reads it, under
+// `drain_mutex`.
+struct GLErrorRing {
+    GLErrorSlot slots[GL_ERROR_RING_SIZE];
+    std::atomic<std::size_t> write = 0;
+    std::size_t read = 0;
+    std::atomic<std::size_t> dropped = 0;
+
+    GLErrorRing()
+    {
+        for (std::size_t i = 0; i < GL_ERROR_RING_SIZE; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    void push(const char* file, int line, GLenum error, std::size_t count)
+    {
+        std::size_t position = write.load(std::memory_order_relaxed);
+        GLErrorSlot* slot;
+
+        while (true) {
+            slot = &slots[position % GL_ERROR_RING_SIZE];
+            std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+
+            if (sequence == position) {
+                if (write.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            } else if (sequence < position) {
+                dropped.fetch_add(count, std::memory_order_relaxed);
+                return;
+            } else {
+                position = write.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->file = file;
+        slot->line = line;
+        slot->error = error;
+        slot->count = count;
+        slot->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    bool pop(const char*& file, int& line, GLenum& error, std::size_t& count)
+    {
+        GLErrorSlot& slot = slots[read % GL_ERROR_RING_SIZE];
+        if (slot.sequence.load(std::memory_order_acquire) != read + 1)
+            return false;
+
+        file = slot.file;
+        line = slot.line;
+        error = slot.error;
+        count = slot.count;
+        slot.sequence.store(read + GL_ERROR_RING_SIZE, std::memory_order_release);
+        read += 1;
+
+        return true;
+    }
+};
+
+// Occurrences of one error code at one call site
+struct GLErrorSite {
+    std::size_t unreported = 0;
+    std::chrono::steady_clock::time_point reported;
+};
+
+// The last error a thread queued, and its repeats not queued yet
+struct GLErrorRepeats {
+    const char* file = nullptr;
+    int line = 0;
+    GLenum error = GL_NO_ERROR;
+    std::size_t count = 0;
+};
+
+static GLErrorRing error_ring;
+static thread_local GLErrorRepeats error_repeats;
+
+static std::mutex drain_mutex;
+static std::map<std::tuple<const char*, int, GLenum>, GLErrorSite> error_sites;
+static std::size_t dropped_errors = 0;
+static std::chrono::steady_clock::time_point dropped_reported;
+
+static std::mutex thread_mutex;
+static std::condition_variable thread_condition;
+static std::thread* error_thread = nullptr;
+static bool error_thread_stopping = false;
+
+static std::once_flag exit_flush_flag;
+static std::terminate_handler previous_terminate_handler = nullptr;
+
+static const char* gl_error_name(GLenum error)
+{
+    switch (error) {
+
+    case GL_INVALID_ENUM:
+        return "GL_INVALID_ENUM";
+    case GL_INVALID_VALUE:
+        return "GL_INVALID_VALUE";
+    case GL_INVALID_OPERATION:
+        return "GL_INVALID_OPERATION";
+    case GL_INVALID_FRAMEBUFFER_OPERATION:
+        return "GL_INVALID_FRAMEBUFFER_OPERATION";
+    case GL_OUT_OF_MEMORY:
+        return "GL_OUT_OF_MEMORY";
+
+    default:
+        return "unknown error";
+    }
+}
+
+static void write_error(const char* file, int line, GLenum error)
+{
+    std::cerr << file << ":" << line
+              << ": ERROR: OpenGL error: error code 0x"
+              << std::hex << error << std::dec
+              << " (" << gl_error_name(error) << ")";
+}
+
+// Writes the repeats of every site whose last report is older than the
+// report interval, or of every site when `all` is set
+static void report_repeats(std::chrono::steady_clock::time_point now, bool all)
+{
+    for (auto& [key, site] : error_sites) {
+        if (site.unreported == 0 || (!all && now - site.reported < GL_ERROR_REPORT_INTERVAL))
+            continue;
+
+        auto [file, line, error] = key;
+        write_error(file, line, error);
+        std::cerr << " repeated " << site.unreported << " more times\n";
+
+        site.unreported = 0;
+        site.reported = now;
+    }
+}
+
+// Must be called with `drain_mutex` held
+static void drain_errors_locked(bool all)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    const char* file;
+    int line;
+    GLenum error;
+    std::size_t count;
+    while (error_ring.pop(file, line, error, count)) {
+        auto [site, inserted] = error_sites.try_emplace({ file, line, error });
+        if (inserted) {
+            write_error(file, line, error);
+            std::cerr << "\n";
+            site->second.reported = now;
+            count -= 1;
+        }
+        site->second.unreported += count;
+    }
+
+    report_repeats(now, all);
+
+    dropped_errors += error_ring.dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped_errors != 0 && (all || now - dropped_reported >= GL_ERROR_REPORT_INTERVAL)) {
+        std::cerr << "ERROR: " << dropped_errors
+                  << " OpenGL errors were dropped, more than " << GL_ERROR_RING_SIZE
+                  << " were queued between two flushes\n";
+
+        dropped_errors = 0;
+        dropped_reported = now;
+    }
+}
+
+static void drain_errors(bool all)
+{
+    std::lock_guard<std::mutex> lock(drain_mutex);
+    drain_errors_locked(all);
+}
+
+static void queue_repeats()
+{
+    if (error_repeats.count == 0)
+        return;
+
+    error_ring.push(error_repeats.file, error_repeats.line, error_repeats.error, error_repeats.count);
+    error_repeats.count = 0;
+}
+
+static void queue_error(const char* file, int line, GLenum error)
+{
+    bool is_repeat = error_repeats.file == file && error_repeats.line == line
+        && error_repeats.error == error;
+
+    if (is_repeat) {
+        error_repeats.count += 1;
+        if (error_repeats.count == GL_ERROR_COALESCE_LIMIT)
+            queue_repeats();
+        return;
+    }
+
+    queue_repeats();
+    error_ring.push(file, line, error, 1);
+    error_repeats = { .file = file, .line = line, .error = error, .count = 0 };
+}
+
+// Fatal errors end the program through std::terminate(), which skips the
+// atexit handlers. The thread that terminates may be the one draining, in
+// which case the errors are lost rather than waited for.
+static void write_errors_on_terminate()
+{
+    queue_repeats();
+    {
+        std::unique_lock<std::mutex> lock(drain_mutex, std::try_to_lock);
+        if (lock.owns_lock())
+            drain_errors_locked(true);
+    }
+
+    if (previous_terminate_handler != nullptr)
+        previous_terminate_handler();
+    std::abort();
+}
+
 namespace GL {
 
 void clear_errors()
 {
-    while (glGetError() != GL_NO_ERROR)
+    while (gl_fn(GetError)() != GL_NO_ERROR)
         ;
 }
 
 void check_errors(const char* file_path, int line)
 {
-    while (GLenum error = glGetError()) {
-        std::cerr << file_path << ":" << line
-                  << ": ERROR: OpenGL error: error code 0x"
-                  << std::hex << error << std::dec << std::endl;
+    bool failed = false;
+
+    while (GLenum error = gl_fn(GetError)()) {
+        // Whatever is still queued gets written when the program exits,
+        // normally or not
+        std::call_once(exit_flush_flag, [] {
+            std::atexit([] {
+                queue_repeats();
+                drain_errors(true);
+            });
+            previous_terminate_handler = std::set_terminate(write_errors_on_terminate);
+        });
+
+        queue_error(file_path, line, error);
+        failed = true;
+    }
+
+    // A run of repeats ends with the first call that succeeds
+    if (!failed)
+        queue_repeats();
+}
+
+void flush_gl_errors()
+{
+    queue_repeats();
+    drain_errors(false);
+}
+
+void start_gl_error_thread(std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> lock(thread_mutex);
+    if (error_thread != nullptr)
+        return;
+
+    error_thread_stopping = false;
+    error_thread = new std::thread([interval] {
+        std::unique_lock<std::mutex> lock(thread_mutex);
+
+        while (!thread_condition.wait_for(lock, interval, [] { return error_thread_stopping; })) {
+            lock.unlock();
+            drain_errors(false);
+            lock.lock();
+        }
+    });
+}
+
+void stop_gl_error_thread()
+{
+    std::thread* thread;
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex);
+        if (error_thread == nullptr)
+            return;
+
+        error_thread_stopping = true;
+        thread = error_thread;
+        error_thread = nullptr;
     }
+
+    thread_condition.notify_all();
+    thread->join();
+    delete thread;
+
+    drain_errors(true);
 }
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,188 @@
+#include "opengl/gl_stats.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#define GL_STATS_EXIT_REPORT_COUNT 20
+
+// Bytes per pixel of uncompressed texture data
+static std::size_t pixel_size(GLenum format, GLenum type)
+{
+    switch (type) {
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+        return 2;
+    case GL_UNSIGNED_INT_8_8_8_8:
+    case GL_UNSIGNED_INT_8_8_8_8_REV:
+    case GL_UNSIGNED_INT_2_10_10_10_REV:
+    case GL_UNSIGNED_INT_24_8:
+        return 4;
+    }
+
+    std::size_t components = 4;
+    switch (format) {
+    case GL_RED:
+    case GL_RED_INTEGER:
+    case GL_DEPTH_COMPONENT:
+        components = 1;
+        break;
+    case GL_RG:
+    case GL_RG_INTEGER:
+        components = 2;
+        break;
+    case GL_RGB:
+    case GL_BGR:
+        components = 3;
+        break;
+    }
+
+    switch (type) {
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+        return components * 2;
+    case GL_INT:
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+        return components * 4;
+    default:
+        return components;
+    }
+}
+
+// Of the context current on the calling thread, as bound through `gl()`.
+// Texture uploads read their pixels from it when it is not 0, their pixel
+// pointer is then an offset into it, which may be 0.
+static thread_local GLuint unpack_buffer = 0;
+
+static std::mutex call_sites_mutex;
+static std::vector<GL::GLCallStats*> call_sites;
+
+static void print_call_site(std::ostream& out, const GL::GLCallStats& site,
+                            std::uint64_t calls, std::uint64_t nanoseconds, std::uint64_t bytes)
+{
+    out << "    " << std::setw(10) << calls << " calls "
+        << std::setw(10) << std::fixed << std::setprecision(3) << nanoseconds / 1e6 << " ms "
+        << std::setw(12) << bytes << " bytes  "
+        << site.file << ":" << site.line << " " << site.call << "\n";
+    out << std::defaultfloat;
+}
+
+namespace GL {
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+
+std::size_t gl_upload_size_BindBuffer(GLenum target, GLuint buffer)
+{
+    if (target == GL_PIXEL_UNPACK_BUFFER)
+        unpack_buffer = buffer;
+
+    return 0;
+}
+
+std::size_t gl_upload_size_BufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+{
+    return data != nullptr ? size : 0;
+}
+
+std::size_t gl_upload_size_BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    return size;
+}
+
+std::size_t gl_upload_size_CompressedTexImage2D(GLenum target, GLint level, GLenum internalformat,
+                                                GLsizei width, GLsizei height, GLint border,
+                                                GLsizei image_size, const void* data)
+{
+    return data != nullptr || unpack_buffer != 0 ? image_size : 0;
+}
+
+std::size_t gl_upload_size_TexImage2D(GLenum target, GLint level, GLint internalformat,
+                                      GLsizei width, GLsizei height, GLint border,
+                                      GLenum format, GLenum type, const void* pixels)
+{
+    if (pixels == nullptr && unpack_buffer == 0)
+        return 0;
+
+    return std::size_t(width) * height * pixel_size(format, type);
+}
+
+// Always uploads, the pixels come either from client memory or from the
+// pixel unpack buffer
+std::size_t gl_upload_size_TexSubImage2D(GLenum target, GLint level, GLint x, GLint y,
+                                         GLsizei width, GLsizei height,
+                                         GLenum format, GLenum type, const void* pixels)
+{
+    return std::size_t(width) * height * pixel_size(format, type);
+}
+
+#pragma GCC diagnostic pop
+
+GLCallStats* register_gl_call_site(const char* file, int line, const char* call)
+{
+    std::lock_guard<std::mutex> lock(call_sites_mutex);
+
+    if (call_sites.empty()) {
+        std::atexit([] {
+            std::cerr << "[INFO] GL call sites by time spent in GL:\n";
+            print_gl_stats(std::cerr, GL_STATS_EXIT_REPORT_COUNT);
+        });
+    }
+
+    GLCallStats* stats = new GLCallStats();
+    stats->file = file;
+    stats->line = line;
+    stats->call = call;
+    call_sites.push_back(stats);
+
+    return stats;
+}
+
+void end_gl_stats_frame(std::ostream* out)
+{
+    std::vector<GLCallStats*> sites;
+    {
+        std::lock_guard<std::mutex> lock(call_sites_mutex);
+        sites = call_sites;
+    }
+
+    if (out != nullptr) {
+        std::erase_if(sites, [](const GLCallStats* site) { return site->frame_calls == 0; });
+        std::sort(sites.begin(), sites.end(), [](const GLCallStats* a, const GLCallStats* b) {
+            return a->frame_nanoseconds > b->frame_nanoseconds;
+        });
+
+        for (const GLCallStats* site : sites)
+            print_call_site(*out, *site, site->frame_calls, site->frame_nanoseconds, site->frame_bytes);
+    }
+
+    for (GLCallStats* site : sites) {
+        site->frame_calls = 0;
+        site->frame_nanoseconds = 0;
+        site->frame_bytes = 0;
+    }
+}
+
+void print_gl_stats(std::ostream& out, std::size_t count)
+{
+    std::vector<GLCallStats*> sites;
+    {
+        std::lock_guard<std::mutex> lock(call_sites_mutex);
+        sites = call_sites;
+    }
+
+    std::sort(sites.begin(), sites.end(), [](const GLCallStats* a, const GLCallStats* b) {
+        return a->nanoseconds > b->nanoseconds;
+    });
+
+    for (std::size_t i = 0; i < sites.size() && i < count; ++i)
+        print_call_site(out, *sites[i], sites[i]->calls, sites[i]->nanoseconds, sites[i]->bytes);
+}
+
+}
@@ -0,0 +1,84 @@
+#include "opengl/glfw_context.hpp"
+
+#include <iostream>
+
+#include "opengl/gl_errors.hpp"
+
+namespace GL {
+
+GlfwContext::GlfwContext(const ContextConfig& config)
+{
+    if (!glfwInit()) {
+        std::cerr << "ERROR: could not initialize GLFW\n";
+        return;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, config.major_version);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, config.minor_version);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    m_window = glfwCreateWindow(config.width, config.height, config.title, nullptr, nullptr);
+    if (m_window == nullptr) {
+        std::cerr << "ERROR: could not create a window with OpenGL "
+                  << config.major_version << "." << config.minor_version << "\n";
+        glfwTerminate();
+        return;
+    }
+
+    int width, height;
+    glfwGetFramebufferSize(m_window, &width, &height);
+    m_width = width;
+    m_height = height;
+
+    glfwSetWindowUserPointer(m_window, this);
+    glfwSetFramebufferSizeCallback(m_window, on_framebuffer_resize);
+
+    glfwMakeContextCurrent(m_window);
+}
+
+GlfwContext::~GlfwContext()
+{
+    if (m_window == nullptr)
+        return;
+
+    glfwDestroyWindow(m_window);
+    glfwTerminate();
+}
+
+void GlfwContext::on_framebuffer_resize(GLFWwindow* window, int width, int height)
+{
+    GlfwContext* context = static_cast<GlfwContext*>(glfwGetWindowUserPointer(window));
+    context->m_width = width;
+    context->m_height = height;
+
+    gl(Viewport, (0, 0, width, height));
+}
+
+bool GlfwContext::should_close() const
+{
+    return glfwWindowShouldClose(m_window);
+}
+
+void GlfwContext::swap_buffers()
+{
+    glfwSwapBuffers(m_window);
+    flush_gl_errors();
+}
+
+void GlfwContext::poll_events()
+{
+    glfwPollEvents();
+}
+
+Context* create_glfw_context(const ContextConfig& config)
+{
+    GlfwContext* context = new GlfwContext(config);
+    if (!context->is_valid()) {
+        delete context;
+        return nullptr;
+    }
+
+    return context;
+}
+
+}
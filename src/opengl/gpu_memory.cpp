@@ -0,0 +1,262 @@
+#include "opengl/gpu_memory.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+#include <GL/glew.h>
+
+#include "opengl/gl_errors.hpp"
+
+#define GPU_RESOURCE_TYPE_COUNT static_cast<std::size_t>(GL::GpuResourceType::COUNT)
+
+// Budgets of 0 are not checked
+struct GpuMemoryBudget {
+    std::size_t bytes = 0;
+    bool exceeded = false;
+};
+
+static std::mutex memory_mutex;
+static GL::GpuMemoryUsage total_usage;
+static GL::GpuMemoryUsage type_usage[GPU_RESOURCE_TYPE_COUNT];
+static std::map<std::string, GL::GpuMemoryUsage> label_usage;
+
+static GpuMemoryBudget total_budget;
+static GpuMemoryBudget type_budgets[GPU_RESOURCE_TYPE_COUNT];
+
+// Unlabelled resources only count towards their type and the total
+static GL::GpuMemoryUsage* usage_of_label(const std::string& label)
+{
+    return label.empty() ? nullptr : &label_usage[label];
+}
+
+static void add_bytes(GL::GpuMemoryUsage* usage, std::size_t bytes)
+{
+    if (usage == nullptr)
+        return;
+
+    usage->bytes += bytes;
+    usage->peak = std::max(usage->peak, usage->bytes);
+}
+
+static void remove_bytes(GL::GpuMemoryUsage* usage, std::size_t bytes)
+{
+    if (usage == nullptr)
+        return;
+
+    usage->bytes -= std::min(usage->bytes, bytes);
+}
+
+static void check_budget(GpuMemoryBudget& budget, const GL::GpuMemoryUsage& usage, const char* name)
+{
+    if (budget.bytes == 0)
+        return;
+
+    if (usage.bytes <= budget.bytes) {
+        budget.exceeded = false;
+        return;
+    }
+
+    if (budget.exceeded)
+        return;
+
+    budget.exceeded = true;
+    std::cerr << "ERROR: GPU memory: " << name << " use " << usage.bytes
+              << " bytes, over their budget of " << budget.bytes << " bytes\n";
+}
+
+static void check_budgets(GL::GpuResourceType type)
+{
+    std::size_t index = static_cast<std::size_t>(type);
+
+    check_budget(type_budgets[index], type_usage[index], GL::gpu_resource_type_name(type));
+    check_budget(total_budget, total_usage, "all resources");
+}
+
+static void print_usage(std::ostream& out, const std::string& name, const GL::GpuMemoryUsage& usage)
+{
+    out << "    " << name << ": " << usage.bytes << " bytes, peak " << usage.peak
+        << " bytes, churn " << usage.churn << " bytes\n";
+}
+
+namespace GL {
+
+const char* gpu_resource_type_name(GpuResourceType type)
+{
+    switch (type) {
+
+    case GpuResourceType::VERTEX_BUFFER:
+        return "vertex buffers";
+    case GpuResourceType::INDEX_BUFFER:
+        return "index buffers";
+    case GpuResourceType::STORAGE_BUFFER:
+        return "storage buffers";
+    case GpuResourceType::INDIRECT_BUFFER:
+        return "indirect buffers";
+    case GpuResourceType::STAGING_BUFFER:
+        return "staging buffers";
+    case GpuResourceType::TEXTURE:
+        return "textures";
+
+    default:
+        return "unknown";
+    }
+}
+
+void track_gpu_allocation(GpuResourceType type, const std::string& label, std::size_t bytes)
+{
+    if (bytes == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(memory_mutex);
+
+    add_bytes(&total_usage, bytes);
+    add_bytes(&type_usage[static_cast<std::size_t>(type)], bytes);
+    add_bytes(usage_of_label(label), bytes);
+
+    check_budgets(type);
+}
+
+void track_gpu_free(GpuResourceType type, const std::string& label, std::size_t bytes)
+{
+    if (bytes == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(memory_mutex);
+
+    remove_bytes(&total_usage, bytes);
+    remove_bytes(&type_usage[static_cast<std::size_t>(type)], bytes);
+    remove_bytes(usage_of_label(label), bytes);
+
+    check_budgets(type);
+}
+
+void track_gpu_reallocation(GpuResourceType type, const std::string& label,
+                            std::size_t old_bytes, std::size_t new_bytes)
+{
+    std::lock_guard<std::mutex> lock(memory_mutex);
+
+    GpuMemoryUsage* usages[] = {
+        &total_usage,
+        &type_usage[static_cast<std::size_t>(type)],
+        usage_of_label(label),
+    };
+
+    // The old storage stays alive until the new one is filled, so it
+    // counts towards the peak
+    for (GpuMemoryUsage* usage : usages) {
+        if (usage == nullptr)
+            continue;
+
+        add_bytes(usage, new_bytes);
+        remove_bytes(usage, old_bytes);
+        usage->churn += old_bytes;
+    }
+
+    check_budgets(type);
+}
+
+void track_gpu_relabel(const std::string& old_label, const std::string& new_label, std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(memory_mutex);
+
+    remove_bytes(usage_of_label(old_label), bytes);
+    add_bytes(usage_of_label(new_label), bytes);
+}
+
+GpuMemoryUsage gpu_memory_usage()
+{
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    return total_usage;
+}
+
+GpuMemoryUsage gpu_memory_usage(GpuResourceType type)
+{
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    return type_usage[static_cast<std::size_t>(type)];
+}
+
+std::vector<std::pair<std::string, GpuMemoryUsage>> gpu_memory_usage_by_label()
+{
+    std::lock_guard<std::mutex> lock(memory_mutex);
+    return { label_usage.begin(), label_usage.end() };
+}
+
+void set_gpu_memory_budget(std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(memory_mutex);
+
+    total_budget = { .bytes = bytes, .exceeded = false };
+    check_budget(total_budget, total_usage, "all resources");
+}
+
+void set_gpu_memory_budget(GpuResourceType type, std::size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(memory_mutex);
+
+    std::size_t index = static_cast<std::size_t>(type);
+    type_budgets[index] = { .bytes = bytes, .exceeded = false };
+    check_budget(type_budgets[index], type_usage[index], gpu_resource_type_name(type));
+}
+
+bool query_gpu_driver_memory(GpuDriverMemory& memory)
+{
+    memory = GpuDriverMemory();
+
+    // Both extensions report kilobytes
+    if (GLEW_NVX_gpu_memory_info) {
+        GLint dedicated = 0;
+        GLint total_available = 0;
+        GLint available = 0;
+        gl(GetIntegerv, (GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &dedicated));
+        gl(GetIntegerv, (GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total_available));
+        gl(GetIntegerv, (GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available));
+
+        memory.dedicated = std::size_t(dedicated) * 1024;
+        memory.total_available = std::size_t(total_available) * 1024;
+        memory.available = std::size_t(available) * 1024;
+        return true;
+    }
+
+    if (GLEW_ATI_meminfo) {
+        // Free memory of the pool, largest free block, then the same for
+        // the auxiliary memory the pool spills into
+        GLint texture_pool[4] = { 0 };
+        GLint buffer_pool[4] = { 0 };
+        gl(GetIntegerv, (GL_TEXTURE_FREE_MEMORY_ATI, texture_pool));
+        gl(GetIntegerv, (GL_VBO_FREE_MEMORY_ATI, buffer_pool));
+
+        memory.available = std::size_t(texture_pool[0]) * 1024;
+        memory.buffer_available = std::size_t(buffer_pool[0]) * 1024;
+        return true;
+    }
+
+    return false;
+}
+
+void print_gpu_memory(std::ostream& out)
+{
+    out << "[INFO] GPU memory by type:\n";
+    for (std::size_t i = 0; i < GPU_RESOURCE_TYPE_COUNT; ++i)
+        print_usage(out, gpu_resource_type_name(static_cast<GpuResourceType>(i)), gpu_memory_usage(static_cast<GpuResourceType>(i)));
+    print_usage(out, "total", gpu_memory_usage());
+
+    out << "[INFO] GPU memory by label:\n";
+    for (const auto& [label, usage] : gpu_memory_usage_by_label())
+        print_usage(out, label, usage);
+
+    GpuDriverMemory driver;
+    if (query_gpu_driver_memory(driver)) {
+        out << "[INFO] GPU memory reported by the driver:\n";
+        if (driver.dedicated != 0)
+            out << "    dedicated: " << driver.dedicated << " bytes\n";
+        if (driver.total_available != 0)
+            out << "    total available: " << driver.total_available << " bytes\n";
+        out << "    available: " << driver.available << " bytes\n";
+        if (driver.buffer_available != 0)
+            out << "    available to buffers: " << driver.buffer_available << " bytes\n";
+    }
+}
+
+}
@@ -0,0 +1,219 @@
+#include "opengl/gpu_profiler.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "opengl/gl_errors.hpp"
+#include "opengl/trace.hpp"
+
+namespace GL {
+
+GpuProfiler::GpuProfiler(std::size_t window)
+    : m_window(std::max<std::size_t>(window, 1))
+{
+    m_supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+}
+
+GpuProfiler::~GpuProfiler()
+{
+    for (Frame& frame : m_frames) {
+        if (!frame.queries.empty())
+            gl(DeleteQueries, (frame.queries.size(), frame.queries.data()));
+    }
+}
+
+bool GpuProfiler::read_frame(Frame& frame, bool wait)
+{
+    if (!wait) {
+        // Timestamps are written in order, so the last one being available
+        // means every other one is
+        GLint available = GL_FALSE;
+        gl(GetQueryObjectiv, (frame.queries[frame.zones.size() * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available));
+        if (!available)
+            return false;
+    }
+
+    for (std::size_t i = 0; i < frame.zones.size(); ++i) {
+        gl(GetQueryObjectui64v, (frame.queries[i * 2], GL_QUERY_RESULT, &frame.zones[i].start));
+        gl(GetQueryObjectui64v, (frame.queries[i * 2 + 1], GL_QUERY_RESULT, &frame.zones[i].end));
+    }
+
+#ifdef OPENGL_TRACE
+    if (frame.trace_offset != 0) {
+        for (const GpuZone& zone : frame.zones)
+            trace_gpu_zone(zone.name, zone.start + frame.trace_offset, zone.end + frame.trace_offset);
+    }
+#endif
+
+    frame.pending = false;
+    m_last_frame = frame.zones;
+    m_last_frame_number = frame.number;
+    record_history(frame.zones);
+
+    return true;
+}
+
+void GpuProfiler::record_history(const std::vector<GpuZone>& zones)
+{
+    // Zones with the same path in a frame add up to one sample
+    std::vector<std::string> paths(zones.size());
+    std::vector<std::pair<std::string, double>> samples;
+
+    for (std::size_t i = 0; i < zones.size(); ++i) {
+        const GpuZone& zone = zones[i];
+        paths[i] = zone.parent == GPU_ZONE_NO_PARENT
+            ? std::string(zone.name)
+            : paths[zone.parent] + "/" + zone.name;
+
+        auto sample = std::find_if(samples.begin(), samples.end(), [&](const auto& sample) {
+            return sample.first == paths[i];
+        });
+        if (sample != samples.end())
+            sample->second += zone.milliseconds();
+        else
+            samples.push_back({ paths[i], zone.milliseconds() });
+    }
+
+    for (const auto& [path, milliseconds] : samples) {
+        auto history = std::find_if(m_history.begin(), m_history.end(), [&](const ZoneHistory& history) {
+            return history.path == path;
+        });
+        if (history == m_history.end()) {
+            m_history.push_back({ .path = path, .samples = {}, .next = 0 });
+            history = m_history.end() - 1;
+        }
+
+        if (history->samples.size() < m_window)
+            history->samples.push_back(milliseconds);
+        else
+            history->samples[history->next] = milliseconds;
+        history->next = (history->next + 1) % m_window;
+    }
+}
+
+void GpuProfiler::begin_frame()
+{
+    if (!m_supported)
+        return;
+
+    if (m_in_frame) {
+        std::cerr << "ERROR: GPU profiler: begin_frame() called twice without end_frame()\n";
+        end_frame();
+    }
+
+    // Oldest first, so that the latest frame read back is the last one
+    for (long number = m_frame_number - GPU_PROFILER_FRAME_COUNT + 1; number <= m_frame_number; ++number) {
+        if (number < 0)
+            continue;
+
+        Frame& frame = m_frames[number % GPU_PROFILER_FRAME_COUNT];
+        if (frame.pending && !read_frame(frame, false))
+            break;
+    }
+
+    m_frame_number += 1;
+
+    // The GPU is a whole ring behind, the oldest frame has to be waited for
+    Frame& frame = current_frame();
+    if (frame.pending)
+        read_frame(frame, true);
+
+    frame.number = m_frame_number;
+    frame.zones.clear();
+    frame.trace_offset = 0;
+    m_in_frame = true;
+
+#ifdef OPENGL_TRACE
+    // Pairs the GPU clock with the CPU clock once per frame, so that the
+    // two timelines do not drift apart
+    if (is_tracing()) {
+        GLint64 gpu_time = 0;
+        gl(GetInteger64v, (GL_TIMESTAMP, &gpu_time));
+        frame.trace_offset = trace_clock() - gpu_time;
+    }
+#endif
+}
+
+void GpuProfiler::end_frame()
+{
+    if (!m_supported || !m_in_frame)
+        return;
+
+    while (!m_open_zones.empty()) {
+        std::cerr << "ERROR: GPU profiler: zone `"
+                  << current_frame().zones[m_open_zones.back()].name
+                  << "` was not ended\n";
+        end_zone();
+    }
+
+    Frame& frame = current_frame();
+    frame.pending = !frame.zones.empty();
+    m_in_frame = false;
+}
+
+void GpuProfiler::begin_zone(const char* name)
+{
+    if (!m_supported || !m_in_frame)
+        return;
+
+    Frame& frame = current_frame();
+    std::size_t index = frame.zones.size();
+
+    if (frame.queries.size() < (index + 1) * 2) {
+        frame.queries.resize((index + 1) * 2);
+        gl(GenQueries, (2, &frame.queries[index * 2]));
+    }
+
+    frame.zones.push_back({
+        .name = name,
+        .parent = m_open_zones.empty() ? GPU_ZONE_NO_PARENT : m_open_zones.back(),
+        .depth = static_cast<unsigned int>(m_open_zones.size()),
+        .start = 0,
+        .end = 0,
+    });
+    m_open_zones.push_back(index);
+
+    gl(QueryCounter, (frame.queries[index * 2], GL_TIMESTAMP));
+}
+
+void GpuProfiler::end_zone()
+{
+    if (!m_supported || !m_in_frame)
+        return;
+
+    if (m_open_zones.empty()) {
+        std::cerr << "ERROR: GPU profiler: end_zone() without a zone to end\n";
+        return;
+    }
+
+    std::size_t index = m_open_zones.back();
+    m_open_zones.pop_back();
+
+    gl(QueryCounter, (current_frame().queries[index * 2 + 1], GL_TIMESTAMP));
+}
+
+std::vector<GpuZoneStats> GpuProfiler::stats() const
+{
+    std::vector<GpuZoneStats> stats;
+
+    for (const ZoneHistory& history : m_history) {
+        if (history.samples.empty())
+            continue;
+
+        double total = 0;
+        for (double sample : history.samples)
+            total += sample;
+
+        stats.push_back({
+            .path = history.path,
+            .samples = history.samples.size(),
+            .min = *std::min_element(history.samples.begin(), history.samples.end()),
+            .average = total / history.samples.size(),
+            .max = *std::max_element(history.samples.begin(), history.samples.end()),
+        });
+    }
+
+    return stats;
+}
+
+}
@@ -0,0 +1,147 @@
+#include "opengl/image.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+#include "opengl/pixels.hpp"
+#include "opengl/trace.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+namespace GL {
+
+// Converts stb's native channel layout to R8G8B8A8, then flips the rows
+// if asked to. stb's own conversion and flip are plain scalar loops, these
+// go through the SIMD kernels in pixels.cpp instead.
+static Image image_from_stb(unsigned char* pixels, int width, int height,
+                            int components, bool flip_vertically)
+{
+    Image image;
+
+    image.width = width;
+    image.height = height;
+    image.format = PixelFormat::R8G8B8A8;
+
+    std::size_t pixel_count = image.width * image.height;
+
+    switch (components) {
+
+    case 4:
+        image.buffer.assign(pixels, pixels + pixel_count * 4);
+        break;
+
+    case 3:
+        image.buffer.resize(pixel_count * 4);
+        expand_rgb_to_rgba(pixels, image.buffer.data(), pixel_count);
+        break;
+
+    default:
+        // Grey and grey + alpha images are rare enough to not need a kernel
+        image.buffer.resize(pixel_count * 4);
+        for (std::size_t i = 0; i < pixel_count; ++i) {
+            unsigned char grey = pixels[i * components];
+            image.buffer[i * 4 + 0] = grey;
+            image.buffer[i * 4 + 1] = grey;
+            image.buffer[i * 4 + 2] = grey;
+            image.buffer[i * 4 + 3] = components == 2 ? pixels[i * 2 + 1] : 0xFF;
+        }
+        break;
+    }
+
+    stbi_image_free(pixels);
+
+    if (flip_vertically)
+        flip_rows(image.pixels(), image.width * 4, image.height);
+
+    return image;
+}
+
+static bool stb_probe(const unsigned char* data, std::size_t size)
+{
+    (void)data;
+    (void)size;
+    return true;
+}
+
+static Image stb_decode(std::vector<unsigned char>&& bytes, bool flip_vertically)
+{
+    int width;
+    int height;
+    int components;
+    unsigned char* pixels = stbi_load_from_memory(bytes.data(), bytes.size(),
+                                                  &width, &height, &components, 0);
+
+    if (pixels == nullptr) {
+        std::cerr << "ERROR: stb_image: " << stbi_failure_reason() << "\n";
+        return Image();
+    }
+
+    return image_from_stb(pixels, width, height, components, flip_vertically);
+}
+
+static const ImageDecoder stb_image_decoder = {
+    .name = "stb_image",
+    .probe = stb_probe,
+    .decode = stb_decode,
+};
+
+static std::vector<ImageDecoder>& image_decoders()
+{
+    static std::vector<ImageDecoder> decoders = {
+        raw_image_decoder,
+        qoi_image_decoder,
+        tga_image_decoder,
+        stb_image_decoder,
+    };
+
+    return decoders;
+}
+
+void register_image_decoder(const ImageDecoder& decoder)
+{
+    image_decoders().insert(image_decoders().begin(), decoder);
+}
+
+Image decode_image(std::vector<unsigned char>&& bytes, bool flip_vertically)
+{
+    trace_scope("decode image");
+
+    for (const ImageDecoder& decoder : image_decoders()) {
+        if (decoder.probe(bytes.data(), bytes.size()))
+            return decoder.decode(std::move(bytes), flip_vertically);
+    }
+
+    return Image();
+}
+
+Image load_image(const std::string& path, bool flip_vertically)
+{
+    std::vector<unsigned char> bytes;
+    if (!read_file(path, bytes))
+        return Image();
+
+    Image image = decode_image(std::move(bytes), flip_vertically);
+    if (!image.is_valid())
+        std::cerr << "ERROR: could not load image `" << path << "`\n";
+
+    return image;
+}
+
+bool read_file(const std::string& path, std::vector<unsigned char>& bytes)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) {
+        std::cerr << "ERROR: could not open file `" << path << "`\n";
+        return false;
+    }
+
+    bytes.resize(stream.tellg());
+    stream.seekg(0);
+    stream.read(reinterpret_cast<char*>(bytes.data()), bytes.size());
+
+    return bool(stream);
+}
+
+}
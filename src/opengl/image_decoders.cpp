@@ -0,0 +1,314 @@
+#include "opengl/image.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "opengl/pixels.hpp"
+
+static std::uint32_t read_le32(const unsigned char* data)
+{
+    return data[0] | data[1] << 8 | data[2] << 16 | std::uint32_t(data[3]) << 24;
+}
+
+static std::uint32_t read_be32(const unsigned char* data)
+{
+    return std::uint32_t(data[0]) << 24 | data[1] << 16 | data[2] << 8 | data[3];
+}
+
+static std::uint16_t read_le16(const unsigned char* data)
+{
+    return data[0] | data[1] << 8;
+}
+
+static void write_le32(unsigned char* data, std::uint32_t value)
+{
+    data[0] = value;
+    data[1] = value >> 8;
+    data[2] = value >> 16;
+    data[3] = value >> 24;
+}
+
+/*                        *
+ *   Raw                  *
+ *                        */
+
+// Layout, all integers little endian:
+//   char     magic[8] = "GLRAWIMG"
+//   uint32_t width
+//   uint32_t height
+//   uint32_t format (GL::PixelFormat)
+//   uint32_t reserved
+//   pixels, top row first, tightly packed
+static const unsigned char raw_magic[8] = { 'G', 'L', 'R', 'A', 'W', 'I', 'M', 'G' };
+
+#define RAW_HEADER_SIZE 24
+
+static bool raw_probe(const unsigned char* data, std::size_t size)
+{
+    return size >= RAW_HEADER_SIZE && std::memcmp(data, raw_magic, sizeof(raw_magic)) == 0;
+}
+
+static bool raw_view(const unsigned char* data, std::size_t size, GL::ImageView& view)
+{
+    if (!raw_probe(data, size))
+        return false;
+
+    std::uint32_t format = read_le32(data + 16);
+
+    if (format > static_cast<std::uint32_t>(GL::PixelFormat::ETC2_RGBA8)
+        || GL::is_compressed(static_cast<GL::PixelFormat>(format))) {
+        std::cerr << "ERROR: raw image: unsupported pixel format " << format << "\n";
+        return false;
+    }
+
+    view.pixels = data + RAW_HEADER_SIZE;
+    view.width = read_le32(data + 8);
+    view.height = read_le32(data + 12);
+    view.format = static_cast<GL::PixelFormat>(format);
+
+    if (RAW_HEADER_SIZE + GL::level_size(view.format, view.width, view.height) > size) {
+        std::cerr << "ERROR: raw image: truncated pixel data\n";
+        return false;
+    }
+
+    return true;
+}
+
+static GL::Image raw_decode(std::vector<unsigned char>&& bytes, bool flip_vertically)
+{
+    GL::ImageView view;
+    if (!raw_view(bytes.data(), bytes.size(), view))
+        return GL::Image();
+
+    GL::Image image;
+    image.width = view.width;
+    image.height = view.height;
+    image.format = view.format;
+
+    // The file contents become the image buffer, the pixels are never copied
+    image.buffer = std::move(bytes);
+    image.buffer.resize(RAW_HEADER_SIZE + GL::level_size(view.format, view.width, view.height));
+    image.offset = RAW_HEADER_SIZE;
+
+    if (flip_vertically)
+        GL::flip_rows(image.pixels(), GL::level_size(image.format, image.width, 1), image.height);
+
+    return image;
+}
+
+/*                        *
+ *   QOI                  *
+ *                        */
+
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING_SIZE 8
+#define QOI_MAX_PIXELS 400000000
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xC0
+#define QOI_OP_RGB 0xFE
+#define QOI_OP_RGBA 0xFF
+#define QOI_MASK_2 0xC0
+
+static bool qoi_probe(const unsigned char* data, std::size_t size)
+{
+    return size >= QOI_HEADER_SIZE + QOI_PADDING_SIZE && std::memcmp(data, "qoif", 4) == 0;
+}
+
+static GL::Image qoi_decode(std::vector<unsigned char>&& bytes, bool flip_vertically)
+{
+    std::uint32_t width = read_be32(bytes.data() + 4);
+    std::uint32_t height = read_be32(bytes.data() + 8);
+
+    if (width == 0 || height == 0 || std::uint64_t(width) * height > QOI_MAX_PIXELS) {
+        std::cerr << "ERROR: QOI image: invalid size " << width << "x" << height << "\n";
+        return GL::Image();
+    }
+
+    GL::Image image;
+    image.width = width;
+    image.height = height;
+    image.format = GL::PixelFormat::R8G8B8A8;
+
+    std::size_t pixel_count = image.width * image.height;
+    image.buffer.resize(pixel_count * 4);
+
+    unsigned char index[64 * 4] = { 0 };
+    unsigned char pixel[4] = { 0, 0, 0, 0xFF };
+    unsigned int run = 0;
+
+    // The 8 byte end marker guarantees that every op can read its full
+    // payload as long as it starts before the marker
+    const unsigned char* data = bytes.data();
+    std::size_t position = QOI_HEADER_SIZE;
+    std::size_t chunks_end = bytes.size() - QOI_PADDING_SIZE;
+
+    unsigned char* out = image.pixels();
+    for (std::size_t i = 0; i < pixel_count; ++i) {
+        if (run > 0) {
+            run -= 1;
+        } else if (position < chunks_end) {
+            unsigned char op = data[position++];
+
+            if (op == QOI_OP_RGB) {
+                pixel[0] = data[position++];
+                pixel[1] = data[position++];
+                pixel[2] = data[position++];
+            } else if (op == QOI_OP_RGBA) {
+                pixel[0] = data[position++];
+                pixel[1] = data[position++];
+                pixel[2] = data[position++];
+                pixel[3] = data[position++];
+            } else if ((op & QOI_MASK_2) == QOI_OP_INDEX) {
+                std::memcpy(pixel, index + op * 4, 4);
+            } else if ((op & QOI_MASK_2) == QOI_OP_DIFF) {
+                pixel[0] += ((op >> 4) & 0x03) - 2;
+                pixel[1] += ((op >> 2) & 0x03) - 2;
+                pixel[2] += (op & 0x03) - 2;
+            } else if ((op & QOI_MASK_2) == QOI_OP_LUMA) {
+                unsigned char next = data[position++];
+                int green_diff = (op & 0x3F) - 32;
+                pixel[0] += green_diff - 8 + ((next >> 4) & 0x0F);
+                pixel[1] += green_diff;
+                pixel[2] += green_diff - 8 + (next & 0x0F);
+            } else if ((op & QOI_MASK_2) == QOI_OP_RUN) {
+                run = op & 0x3F;
+            }
+
+            int hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+            std::memcpy(index + hash * 4, pixel, 4);
+        }
+
+        std::memcpy(out + i * 4, pixel, 4);
+    }
+
+    if (flip_vertically)
+        GL::flip_rows(image.pixels(), image.width * 4, image.height);
+
+    return image;
+}
+
+/*                        *
+ *   TGA                  *
+ *                        */
+
+#define TGA_HEADER_SIZE 18
+#define TGA_TYPE_TRUE_COLOR 2
+#define TGA_TYPE_GREYSCALE 3
+#define TGA_DESCRIPTOR_TOP_FIRST 0x20
+
+static std::size_t tga_pixel_offset(const unsigned char* data)
+{
+    return TGA_HEADER_SIZE + data[0];
+}
+
+// TGA has no magic number, so only uncompressed images whose header is
+// consistent with the file size are accepted. Everything else, including
+// RLE images, is left to stb_image.
+static bool tga_probe(const unsigned char* data, std::size_t size)
+{
+    if (size < TGA_HEADER_SIZE)
+        return false;
+
+    unsigned char color_map_type = data[1];
+    unsigned char image_type = data[2];
+    std::size_t width = read_le16(data + 12);
+    std::size_t height = read_le16(data + 14);
+    unsigned char depth = data[16];
+
+    bool known_layout = (image_type == TGA_TYPE_TRUE_COLOR && (depth == 24 || depth == 32))
+        || (image_type == TGA_TYPE_GREYSCALE && depth == 8);
+
+    return color_map_type == 0
+        && known_layout
+        && width > 0 && height > 0
+        && tga_pixel_offset(data) + width * height * (depth / 8) <= size;
+}
+
+static GL::Image tga_decode(std::vector<unsigned char>&& bytes, bool flip_vertically)
+{
+    const unsigned char* data = bytes.data();
+
+    GL::Image image;
+    image.width = read_le16(data + 12);
+    image.height = read_le16(data + 14);
+    image.format = GL::PixelFormat::R8G8B8A8;
+
+    std::size_t pixel_count = image.width * image.height;
+    std::size_t pixel_offset = tga_pixel_offset(data);
+    unsigned char depth = data[16];
+    bool top_first = data[17] & TGA_DESCRIPTOR_TOP_FIRST;
+
+    if (depth == 32) {
+        // BGRA pixels are swizzled in place in the file buffer
+        image.buffer = std::move(bytes);
+        image.buffer.resize(pixel_offset + pixel_count * 4);
+        image.offset = pixel_offset;
+        GL::swizzle_rgba_to_bgra(image.pixels(), pixel_count);
+    } else if (depth == 24) {
+        image.buffer.resize(pixel_count * 4);
+        GL::expand_rgb_to_rgba(data + pixel_offset, image.pixels(), pixel_count);
+        GL::swizzle_rgba_to_bgra(image.pixels(), pixel_count);
+    } else {
+        image.buffer.resize(pixel_count * 4);
+        for (std::size_t i = 0; i < pixel_count; ++i) {
+            unsigned char grey = data[pixel_offset + i];
+            image.buffer[i * 4 + 0] = grey;
+            image.buffer[i * 4 + 1] = grey;
+            image.buffer[i * 4 + 2] = grey;
+            image.buffer[i * 4 + 3] = 0xFF;
+        }
+    }
+
+    // TGA rows are stored bottom first unless the descriptor says otherwise,
+    // while an unflipped image has its top row first
+    if (top_first == flip_vertically)
+        GL::flip_rows(image.pixels(), image.width * 4, image.height);
+
+    return image;
+}
+
+namespace GL {
+
+const ImageDecoder raw_image_decoder = {
+    .name = "raw",
+    .probe = raw_probe,
+    .decode = raw_decode,
+};
+
+const ImageDecoder qoi_image_decoder = {
+    .name = "qoi",
+    .probe = qoi_probe,
+    .decode = qoi_decode,
+};
+
+const ImageDecoder tga_image_decoder = {
+    .name = "tga",
+    .probe = tga_probe,
+    .decode = tga_decode,
+};
+
+std::vector<unsigned char> encode_raw_image(const Image& image)
+{
+    std::vector<unsigned char> bytes(RAW_HEADER_SIZE + image.byte_size());
+
+    std::memcpy(bytes.data(), raw_magic, sizeof(raw_magic));
+    write_le32(bytes.data() + 8, image.width);
+    write_le32(bytes.data() + 12, image.height);
+    write_le32(bytes.data() + 16, static_cast<std::uint32_t>(image.format));
+    write_le32(bytes.data() + 20, 0);
+    std::memcpy(bytes.data() + RAW_HEADER_SIZE, image.pixels(), image.byte_size());
+
+    return bytes;
+}
+
+bool view_raw_image(const unsigned char* data, std::size_t size, ImageView& view)
+{
+    return raw_view(data, size, view);
+}
+
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opengl/image.hpp"
+#include "opengl/texture.hpp"
+
+namespace GL {
+
+// Decodes images on a pool of worker threads and uploads them on the GL
+// thread through `upload_pending()`, a few at a time. Until its upload
+// happens, a handle resolves to the placeholder texture.
+class AssetLoader {
+public:
+    using Handle = std::size_t;
+
+private:
+    struct Request {
+        Handle handle;
+        std::string path;
+        bool flip_vertically;
+    };
+
+    struct Decoded {
+        Handle handle;
+        std::string path;
+        Image image;
+    };
+
+    const Texture* m_placeholder;
+
+    // Only touched from the GL thread
+    std::vector<Texture*> m_textures;
+
+    std::vector<std::thread> m_workers;
+    bool m_stopping = false;
+
+    std::mutex m_requests_mutex;
+    std::condition_variable m_requests_condition;
+    std::deque<Request> m_requests;
+
+    std::mutex m_decoded_mutex;
+    std::deque<Decoded> m_decoded;
+
+    std::size_t m_pending_count = 0;
+
+    void worker_loop();
+
+public:
+    // `worker_count` of 0 picks one worker per hardware thread
+    AssetLoader(const Texture* placeholder, std::size_t worker_count = 0);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    Handle load_texture(const std::string& path, bool flip_vertically = false);
+    // Hands an already uploaded texture over to the loader, which then owns
+    // it. `texture` may be nullptr, the handle then resolves to the
+    // placeholder.
+    Handle add_texture(Texture* texture);
+
+    // Uploads decoded images until either budget is spent. At least one
+    // image is uploaded per call, so images larger than the byte budget
+    // still make progress.
+    void upload_pending(std::size_t byte_budget,
+                        std::chrono::microseconds time_budget);
+
+    // Blocks until every requested image is decoded and uploaded
+    void finish();
+
+    const Texture& texture(Handle handle) const;
+    bool is_loaded(Handle handle) const { return m_textures[handle] != nullptr; }
+
+    std::size_t pending_count() const { return m_pending_count; }
+};
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "opengl/compute_shader.hpp"
+#include "opengl/shader.hpp"
+#include "opengl/texture.hpp"
+
+namespace GL {
+
+// Asset pack layout, all integers little endian:
+//
+//   AssetPackHeader
+//   AssetPackEntry[entry_count]
+//   blobs, each starting on an ASSET_PACK_ALIGNMENT boundary
+//
+// Shader blobs hold the text of a shader file. Texture blobs hold a raw
+// image (see `encode_raw_image()`) or a DDS/KTX2 container. Mesh blobs
+// start with an AssetPackMeshHeader, followed by the vertices and then the
+// 32-bit indices, each aligned to ASSET_PACK_ALIGNMENT.
+
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_ALIGNMENT 64
+#define ASSET_PACK_NAME_SIZE 64
+
+enum class AssetType : std::uint32_t {
+    SHADER,
+    TEXTURE,
+    MESH,
+};
+
+struct AssetPackHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t entry_count;
+    std::uint32_t reserved;
+};
+
+struct AssetPackEntry {
+    char name[ASSET_PACK_NAME_SIZE];
+    AssetType type;
+    std::uint32_t reserved;
+    std::uint64_t offset;
+    std::uint64_t size;
+};
+
+struct AssetPackMeshHeader {
+    std::uint32_t vertex_stride;
+    std::uint32_t vertex_count;
+    std::uint32_t index_count;
+    std::uint32_t reserved;
+};
+
+struct AssetView {
+    AssetType type;
+    const unsigned char* data;
+    std::size_t size;
+};
+
+struct MeshView {
+    const void* vertices;
+    std::size_t vertex_stride;
+    std::size_t vertex_count;
+    const GLuint* indices;
+    std::size_t index_count;
+};
+
+// Read-only asset pack, memory mapped so assets are uploaded straight from
+// the mapping with no per-asset file access or decoding
+class AssetPack {
+private:
+    const unsigned char* m_data = nullptr;
+    std::size_t m_size = 0;
+
+    // Names point into the mapping
+    std::unordered_map<std::string_view, AssetView> m_assets;
+
+    const AssetView* find(std::string_view name, AssetType type) const;
+
+public:
+    AssetPack(const std::string& path);
+    ~AssetPack();
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    bool is_valid() const { return m_data != nullptr; }
+
+    const AssetView* find(std::string_view name) const;
+
+    // These return nullptr if the asset is missing or malformed, the caller
+    // owns the returned object
+    Shader* load_shader(std::string_view name) const;
+    ComputeShader* load_compute_shader(std::string_view name) const;
+    Texture* load_texture(std::string_view name) const;
+
+    // Fails when the mesh was built for a vertex layout of another stride
+    bool mesh(std::string_view name, std::size_t vertex_stride, MeshView& mesh) const;
+};
+
+// Builds an asset pack in memory and writes it out
+class AssetPackWriter {
+private:
+    struct Asset {
+        std::string name;
+        AssetType type;
+        std::vector<unsigned char> data;
+    };
+
+    std::vector<Asset> m_assets;
+
+public:
+    bool add(const std::string& name, AssetType type, std::vector<unsigned char> data);
+    bool add_mesh(const std::string& name,
+                  const void* vertices, std::size_t vertex_stride, std::size_t vertex_count,
+                  const GLuint* indices, std::size_t index_count);
+
+    bool write(const std::string& path) const;
+};
+
+}
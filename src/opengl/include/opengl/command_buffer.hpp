@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "opengl/index_buffer.hpp"
+#include "opengl/shader.hpp"
+#include "opengl/texture.hpp"
+#include "opengl/vertex_array.hpp"
+#include "opengl/vertex_buffer.hpp"
+
+namespace GL {
+
+enum class CommandType : std::uint32_t {
+    BIND_SHADER,
+    BIND_TEXTURE,
+    BIND_VERTEX_ARRAY,
+    UNIFORM_INT,
+    UNIFORM_VEC3,
+    UNIFORM_VEC4,
+    PUSH_VERTICES,
+    DRAW_ELEMENTS,
+    CLEAR,
+};
+
+// Records draw, bind and uniform commands into a linear arena without
+// making any GL call, so it can be filled from any thread. The GL thread
+// then replays it with `execute()` and recycles it with `reset()`.
+//
+// Recorded objects are referenced, not copied, and must outlive the
+// replay. Vertex data and uniform names are copied into the arena.
+class CommandBuffer {
+private:
+    std::vector<unsigned char> m_arena;
+    std::size_t m_size = 0;
+    std::size_t m_command_count = 0;
+    // Draws are only recorded once a vertex array is bound
+    bool m_vertex_array_bound = false;
+
+    // Returns the payload of a new command, followed by `extra_size` bytes
+    template <typename T>
+    T* push(CommandType type, std::size_t extra_size = 0);
+
+public:
+    CommandBuffer(std::size_t capacity = 64 * 1024);
+
+    void bind_shader(const Shader& shader);
+    void bind_texture(const Texture& texture, GLuint slot);
+    void bind_vertex_array(const VertexArray& vertex_array);
+
+    // Uniforms apply to `shader`, which must be the bound shader on replay
+    void set_uniform(Shader& shader, std::string_view name, int x);
+    void set_uniform(Shader& shader, std::string_view name,
+                     float x, float y, float z);
+    void set_uniform(Shader& shader, std::string_view name,
+                     float x, float y, float z, float w);
+
+    // Copies `count` vertices laid out with the buffer's stride, they are
+    // appended to `vertex_buffer` on replay
+    void push_vertices(VertexBuffer& vertex_buffer, const void* data, std::size_t count);
+    // Draws with the vertex array of the last `bind_vertex_array()`, which
+    // has to be recorded first, the GL state the buffer replays into is
+    // not relied on
+    void draw(const IndexBuffer& index_buffer, GLenum mode,
+              std::size_t first_index, std::size_t index_count,
+              GLint base_vertex = 0);
+    void clear(GLbitfield mask);
+
+    // Replays every command in recording order, on the GL thread
+    void execute() const;
+    // Forgets the commands but keeps the arena memory
+    void reset();
+
+    std::size_t size() const { return m_size; }
+    std::size_t command_count() const { return m_command_count; }
+};
+
+}
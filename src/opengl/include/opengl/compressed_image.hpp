@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "opengl/texture.hpp"
+
+namespace GL {
+
+// Contents of a precompressed texture container. `levels` points into
+// `bytes`, which is why the image can be moved but not copied.
+struct CompressedImage {
+    std::vector<unsigned char> bytes;
+    std::vector<TextureLevel> levels;
+    PixelFormat format = PixelFormat::BC1_RGBA;
+
+    CompressedImage() = default;
+    CompressedImage(const CompressedImage&) = delete;
+    CompressedImage& operator=(const CompressedImage&) = delete;
+    CompressedImage(CompressedImage&&) = default;
+    CompressedImage& operator=(CompressedImage&&) = default;
+
+    bool is_valid() const { return !levels.empty(); }
+};
+
+// Loads a DDS or KTX2 file holding BC1, BC3, BC7 or ETC2 RGBA8 data,
+// including its mip chain. Only the first layer and face are loaded, and
+// supercompressed KTX2 files are rejected.
+CompressedImage load_compressed_image(const std::string& path);
+
+// Same as `load_compressed_image()` for a container already in memory,
+// `levels` point into `data`
+bool parse_compressed_image(const unsigned char* data, std::size_t size,
+                            PixelFormat& format, std::vector<TextureLevel>& levels);
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <GL/glew.h>
+
+#include "opengl/shader.hpp"
+
+namespace GL {
+
+// A shader made of a single `#shader compute` stage. Compute shaders need
+// OpenGL 4.3 or GL_ARB_compute_shader.
+class ComputeShader : public Shader {
+private:
+    void check_compute_stage();
+
+public:
+    ComputeShader(const std::string& path);
+    ComputeShader(const std::string& name, std::string_view source);
+
+    // The `local_size_x/y/z` the shader was declared with
+    void local_size(GLint size[3]) const;
+
+    // Binds the shader and dispatches `x * y * z` work groups
+    void dispatch(GLuint x, GLuint y = 1, GLuint z = 1);
+    // Dispatches enough work groups along x for `count` invocations, the
+    // shader has to skip the invocations past `count` itself
+    void dispatch_items(std::size_t count);
+};
+
+// Makes the writes of previous dispatches visible to the operations in
+// `barriers`, for example GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT before drawing
+// from a buffer a compute shader filled
+void memory_barrier(GLbitfield barriers);
+
+bool is_compute_supported();
+
+}
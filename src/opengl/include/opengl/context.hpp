@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace GL {
+
+struct ContextConfig {
+    std::size_t width = 640;
+    std::size_t height = 480;
+    const char* title = "OpenGL";
+
+    int major_version = 3;
+    int minor_version = 3;
+
+    // Renders into an offscreen framebuffer instead of a window, so that no
+    // display is needed
+    bool headless = false;
+};
+
+// An OpenGL context together with what it renders to, either a window or
+// an offscreen framebuffer
+class Context {
+protected:
+    std::size_t m_width = 0;
+    std::size_t m_height = 0;
+
+public:
+    virtual ~Context() = default;
+
+    // Called once OpenGL is loaded, sets up what the backend renders to
+    virtual bool init_gl() { return true; }
+
+    virtual bool is_headless() const = 0;
+    virtual bool should_close() const = 0;
+    virtual void swap_buffers() = 0;
+    virtual void poll_events() = 0;
+
+    // The framebuffer drawing goes to, 0 for a window
+    virtual GLuint framebuffer() const = 0;
+
+    std::size_t width() const { return m_width; }
+    std::size_t height() const { return m_height; }
+
+    // Reads back the framebuffer as tightly packed R8G8B8A8 rows, bottom
+    // row first
+    void read_pixels(std::vector<unsigned char>& pixels) const;
+};
+
+// Creates a context with the backend `config` asks for, makes it current
+// and loads OpenGL. Returns nullptr on failure.
+Context* create_context(const ContextConfig& config);
+
+// Backends, they return nullptr when the library was built without them
+Context* create_glfw_context(const ContextConfig& config);
+Context* create_egl_context(const ContextConfig& config);
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+namespace GL {
+
+// Why a RenderQueue ended a multi draw before the next item
+enum class FlushReason {
+    BLEND,
+    SHADER,
+    TEXTURE,
+    // Vertex array, index buffer or primitive mode
+    GEOMETRY,
+    // The last batch of a submit
+    END,
+    COUNT,
+};
+
+const char* flush_reason_name(FlushReason reason);
+
+// What the library asked of GL during a frame. Counted by the library's
+// wrappers, calls made to GL directly are not seen.
+struct FrameStats {
+    // GL draw calls, a multi draw counts once
+    std::size_t draw_calls = 0;
+    // Vertices and indices pushed to vertex and index buffers
+    std::size_t vertices = 0;
+    std::size_t indices = 0;
+    // Indices read by the draw calls
+    std::size_t indices_drawn = 0;
+
+    // Data handed to vertex, index, storage, indirect and pixel unpack
+    // buffers, including the copies made when they grow
+    std::size_t buffer_bytes_uploaded = 0;
+    // Buffers whose storage was reallocated to grow
+    std::size_t buffer_reallocations = 0;
+
+    std::size_t texture_binds = 0;
+    std::size_t program_binds = 0;
+
+    // Uniforms set to a new value, and uniforms set to the value they
+    // already had, which are not sent to GL
+    std::size_t uniform_uploads = 0;
+    std::size_t uniform_uploads_skipped = 0;
+
+    std::size_t flushes[static_cast<std::size_t>(FlushReason::COUNT)] = {};
+
+    std::size_t flush_count(FlushReason reason) const { return flushes[static_cast<std::size_t>(reason)]; }
+    std::size_t flush_count() const;
+};
+
+// Counters of the frame in progress, for the library to add to
+FrameStats& frame_stats();
+
+// Ends the frame in progress, its counters become `last_frame_stats()`
+// and the next frame starts from zero
+void end_frame_stats();
+const FrameStats& last_frame_stats();
+
+void print_frame_stats(std::ostream& out, const FrameStats& stats);
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+
+#include "opengl/gl_functions.hpp"
+
+namespace GL {
+
+// The GL entry points `gl()` and `gl_call()` go through when the library is
+// built with the `gl_dispatch` option. Pointing the table somewhere else
+// swaps the GL implementation under every wrapper at once.
+struct GLDispatchTable {
+#define GL_FUNCTION(name, return_type, params, args, kind) return_type(*name) params;
+    GL_FUNCTIONS
+#undef GL_FUNCTION
+};
+
+extern GLDispatchTable gl_dispatch;
+
+enum class GLFunction {
+#define GL_FUNCTION(name, return_type, params, args, kind) name,
+    GL_FUNCTIONS
+#undef GL_FUNCTION
+    COUNT,
+};
+
+const char* gl_function_name(GLFunction function);
+
+enum class GLBackend {
+    // The driver's entry points as loaded by GLEW
+    GLEW,
+    // Records the calls without a context, see `GLRecording`
+    RECORDING,
+};
+
+void set_gl_backend(GLBackend backend);
+GLBackend gl_backend();
+
+// What the recording backend saw since the last `reset_gl_recording()`.
+// Object names are handed out in order, status queries report success and
+// nothing is drawn, which is enough to run the library's code paths in a
+// test and catch a change in how many calls they make.
+struct GLRecording {
+    std::size_t calls = 0;
+    std::size_t counts[static_cast<std::size_t>(GLFunction::COUNT)] = {};
+
+    // Binds, enables and other pipeline state
+    std::size_t state_changes = 0;
+    std::size_t uniform_uploads = 0;
+    // Draws and compute dispatches, a multi draw counts once
+    std::size_t draw_calls = 0;
+    // Buffer and texture data handed to GL
+    std::size_t bytes_uploaded = 0;
+
+    std::size_t count(GLFunction function) const { return counts[static_cast<std::size_t>(function)]; }
+};
+
+const GLRecording& gl_recording();
+void reset_gl_recording();
+
+// Writes the name of every recorded call to `log`, nullptr stops logging
+void set_gl_recording_log(std::ostream* log);
+
+}
@@ -1,9 +1,47 @@
 #pragma once
 
+#include <chrono>
+
+// Names a GL entry point, through the dispatch table when the library is
+// built with the `gl_dispatch` option
+#ifdef OPENGL_GL_DISPATCH
+#include "opengl/gl_dispatch.hpp"
+#define gl_fn(name) GL::gl_dispatch.name
+#else
+#define gl_fn(name) gl##name
+#endif
+
+#ifdef OPENGL_GL_STATS
+#include "opengl/gl_stats.hpp"
+
+// Every call site keeps its own counters, see `GLCallStats`. The
+// arguments of `gl()` are evaluated a second time to size uploads.
+#define gl(name, args)                                                                                     \
+    do {                                                                                                   \
+        static GL::GLCallStats* gl_call_stats = GL::register_gl_call_site(__FILE__, __LINE__, "gl" #name); \
+        GL::clear_errors();                                                                                \
+        {                                                                                                  \
+            GL::GLCallTimer gl_call_timer(gl_call_stats, GL::gl_upload_size_##name args);                  \
+            gl_fn(name) args;                                                                              \
+        }                                                                                                  \
+        GL::check_errors(__FILE__, __LINE__);                                                              \
+    } while (0);
+
+#define gl_call(...)                                                                                         \
+    do {                                                                                                     \
+        static GL::GLCallStats* gl_call_stats = GL::register_gl_call_site(__FILE__, __LINE__, #__VA_ARGS__); \
+        GL::clear_errors();                                                                                  \
+        {                                                                                                    \
+            GL::GLCallTimer gl_call_timer(gl_call_stats, 0);                                                 \
+            __VA_ARGS__;                                                                                     \
+        }                                                                                                    \
+        GL::check_errors(__FILE__, __LINE__);                                                                \
+    } while (0);
+#else
 #define gl(name, args)                        \
     do {                                      \
         GL::clear_errors();                   \
-        gl##name args;                        \
+        gl_fn(name) args;                     \
         GL::check_errors(__FILE__, __LINE__); \
     } while (0);
 
@@ -13,10 +51,24 @@
         __VA_ARGS__;                          \
         GL::check_errors(__FILE__, __LINE__); \
     } while (0);
+#endif
 
 namespace GL {
 
 void clear_errors();
+// Queues the pending GL errors without blocking or writing anything, they
+// are written by the next `flush_gl_errors()`
 void check_errors(const char* file_path, int line);
 
+// Writes the queued errors to std::cerr. Each error code is written once
+// per call site, then its repeats are summed up at most once a second.
+// Called by `Context::swap_buffers()` and when the program exits, through
+// exit() or std::terminate().
+void flush_gl_errors();
+
+// Flushes the errors from a thread of their own every `interval`, for
+// programs that do not swap buffers. Must be stopped before exiting.
+void start_gl_error_thread(std::chrono::milliseconds interval = std::chrono::milliseconds(100));
+void stop_gl_error_thread();
+
 }
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <GL/glew.h>
+
+// Every GL entry point the library calls, as
+//   GL_FUNCTION(name, return type, parameters, arguments, kind)
+// where the kind tells what the recording backend counts the call as:
+// CALL, STATE, UNIFORM, UPLOAD or DRAW. BIND is a state change that upload
+// sizes depend on, see `gl_upload_size_BindBuffer()`.
+#define GL_FUNCTIONS                                                                                                          \
+    GL_FUNCTION(ActiveTexture, void, (GLenum texture), (texture), STATE)                                                    \
+    GL_FUNCTION(AttachShader, void, (GLuint program, GLuint shader), (program, shader), CALL)                                \
+    GL_FUNCTION(BeginQuery, void, (GLenum target, GLuint id), (target, id), CALL)                                           \
+    GL_FUNCTION(BindBuffer, void, (GLenum target, GLuint buffer), (target, buffer), BIND)                                   \
+    GL_FUNCTION(BindBufferBase, void, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer), STATE)         \
+    GL_FUNCTION(BindFramebuffer, void, (GLenum target, GLuint framebuffer), (target, framebuffer), STATE)                   \
+    GL_FUNCTION(BindRenderbuffer, void, (GLenum target, GLuint renderbuffer), (target, renderbuffer), STATE)                \
+    GL_FUNCTION(BindTexture, void, (GLenum target, GLuint texture), (target, texture), STATE)                               \
+    GL_FUNCTION(BindVertexArray, void, (GLuint array), (array), STATE)                                                      \
+    GL_FUNCTION(BlendFunc, void, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor), STATE)                               \
+    GL_FUNCTION(BufferData, void,                                                                                           \
+                (GLenum target, GLsizeiptr size, const void* data, GLenum usage),                                           \
+                (target, size, data, usage), UPLOAD)                                                                        \
+    GL_FUNCTION(BufferSubData, void,                                                                                        \
+                (GLenum target, GLintptr offset, GLsizeiptr size, const void* data),                                        \
+                (target, offset, size, data), UPLOAD)                                                                       \
+    GL_FUNCTION(CheckFramebufferStatus, GLenum, (GLenum target), (target), CALL)                                            \
+    GL_FUNCTION(Clear, void, (GLbitfield mask), (mask), CALL)                                                               \
+    GL_FUNCTION(ClientWaitSync, GLenum, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout), CALL)    \
+    GL_FUNCTION(CompileShader, void, (GLuint shader), (shader), CALL)                                                       \
+    GL_FUNCTION(CompressedTexImage2D, void,                                                                                 \
+                (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height,                          \
+                 GLint border, GLsizei image_size, const void* data),                                                       \
+                (target, level, internalformat, width, height, border, image_size, data), UPLOAD)                           \
+    GL_FUNCTION(CreateProgram, GLuint, (), (), CALL)                                                                        \
+    GL_FUNCTION(CreateShader, GLuint, (GLenum type), (type), CALL)                                                          \
+    GL_FUNCTION(DeleteBuffers, void, (GLsizei n, const GLuint* buffers), (n, buffers), CALL)                                \
+    GL_FUNCTION(DeleteFramebuffers, void, (GLsizei n, const GLuint* framebuffers), (n, framebuffers), CALL)                 \
+    GL_FUNCTION(DeleteProgram, void, (GLuint program), (program), CALL)                                                     \
+    GL_FUNCTION(DeleteQueries, void, (GLsizei n, const GLuint* ids), (n, ids), CALL)                                        \
+    GL_FUNCTION(DeleteRenderbuffers, void, (GLsizei n, const GLuint* renderbuffers), (n, renderbuffers), CALL)              \
+    GL_FUNCTION(DeleteShader, void, (GLuint shader), (shader), CALL)                                                        \
+    GL_FUNCTION(DeleteSync, void, (GLsync sync), (sync), CALL)                                                              \
+    GL_FUNCTION(DeleteTextures, void, (GLsizei n, const GLuint* textures), (n, textures), CALL)                             \
+    GL_FUNCTION(Disable, void, (GLenum cap), (cap), STATE)                                                                  \
+    GL_FUNCTION(DisableVertexAttribArray, void, (GLuint index), (index), STATE)                                             \
+    GL_FUNCTION(DispatchCompute, void, (GLuint x, GLuint y, GLuint z), (x, y, z), DRAW)                                     \
+    GL_FUNCTION(DrawElements, void,                                                                                         \
+                (GLenum mode, GLsizei count, GLenum type, const void* indices),                                             \
+                (mode, count, type, indices), DRAW)                                                                         \
+    GL_FUNCTION(DrawElementsBaseVertex, void,                                                                               \
+                (GLenum mode, GLsizei count, GLenum type, const void* indices, GLint base_vertex),                          \
+                (mode, count, type, indices, base_vertex), DRAW)                                                            \
+    GL_FUNCTION(Enable, void, (GLenum cap), (cap), STATE)                                                                   \
+    GL_FUNCTION(EnableVertexAttribArray, void, (GLuint index), (index), STATE)                                              \
+    GL_FUNCTION(EndQuery, void, (GLenum target), (target), CALL)                                                            \
+    GL_FUNCTION(FenceSync, GLsync, (GLenum condition, GLbitfield flags), (condition, flags), CALL)                          \
+    GL_FUNCTION(Finish, void, (), (), CALL)                                                                                 \
+    GL_FUNCTION(Flush, void, (), (), CALL)                                                                                  \
+    GL_FUNCTION(FramebufferRenderbuffer, void,                                                                              \
+                (GLenum target, GLenum attachment, GLenum renderbuffer_target, GLuint renderbuffer),                        \
+                (target, attachment, renderbuffer_target, renderbuffer), STATE)                                             \
+    GL_FUNCTION(GenBuffers, void, (GLsizei n, GLuint* buffers), (n, buffers), CALL)                                         \
+    GL_FUNCTION(GenFramebuffers, void, (GLsizei n, GLuint* framebuffers), (n, framebuffers), CALL)                          \
+    GL_FUNCTION(GenQueries, void, (GLsizei n, GLuint* ids), (n, ids), CALL)                                                 \
+    GL_FUNCTION(GenRenderbuffers, void, (GLsizei n, GLuint* renderbuffers), (n, renderbuffers), CALL)                       \
+    GL_FUNCTION(GenTextures, void, (GLsizei n, GLuint* textures), (n, textures), CALL)                                      \
+    GL_FUNCTION(GenVertexArrays, void, (GLsizei n, GLuint* arrays), (n, arrays), CALL)                                      \
+    GL_FUNCTION(GetAttachedShaders, void,                                                                                   \
+                (GLuint program, GLsizei max_count, GLsizei* count, GLuint* shaders),                                       \
+                (program, max_count, count, shaders), CALL)                                                                 \
+    GL_FUNCTION(GetBufferSubData, void,                                                                                     \
+                (GLenum target, GLintptr offset, GLsizeiptr size, void* data),                                              \
+                (target, offset, size, data), CALL)                                                                         \
+    GL_FUNCTION(GetError, GLenum, (), (), CALL)                                                                             \
+    GL_FUNCTION(GetInteger64v, void, (GLenum pname, GLint64* data), (pname, data), CALL)                                    \
+    GL_FUNCTION(GetIntegerv, void, (GLenum pname, GLint* data), (pname, data), CALL)                                        \
+    GL_FUNCTION(GetProgramInfoLog, void,                                                                                    \
+                (GLuint program, GLsizei buffer_size, GLsizei* length, GLchar* log),                                        \
+                (program, buffer_size, length, log), CALL)                                                                  \
+    GL_FUNCTION(GetProgramiv, void, (GLuint program, GLenum pname, GLint* params), (program, pname, params), CALL)          \
+    GL_FUNCTION(GetQueryObjectiv, void, (GLuint id, GLenum pname, GLint* params), (id, pname, params), CALL)                \
+    GL_FUNCTION(GetQueryObjectui64v, void, (GLuint id, GLenum pname, GLuint64* params), (id, pname, params), CALL)          \
+    GL_FUNCTION(GetShaderInfoLog, void,                                                                                     \
+                (GLuint shader, GLsizei buffer_size, GLsizei* length, GLchar* log),                                         \
+                (shader, buffer_size, length, log), CALL)                                                                   \
+    GL_FUNCTION(GetShaderiv, void, (GLuint shader, GLenum pname, GLint* params), (shader, pname, params), CALL)             \
+    GL_FUNCTION(GetString, const GLubyte*, (GLenum name), (name), CALL)                                                     \
+    GL_FUNCTION(GetUniformLocation, GLint, (GLuint program, const GLchar* name), (program, name), CALL)                     \
+    GL_FUNCTION(LinkProgram, void, (GLuint program), (program), CALL)                                                       \
+    GL_FUNCTION(MapBufferRange, void*,                                                                                      \
+                (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access),                                     \
+                (target, offset, length, access), CALL)                                                                     \
+    GL_FUNCTION(MaxShaderCompilerThreadsKHR, void, (GLuint count), (count), CALL)                                           \
+    GL_FUNCTION(MemoryBarrier, void, (GLbitfield barriers), (barriers), CALL)                                               \
+    GL_FUNCTION(MultiDrawElementsBaseVertex, void,                                                                          \
+                (GLenum mode, const GLsizei* count, GLenum type, const void* const* indices,                                \
+                 GLsizei draw_count, const GLint* base_vertex),                                                             \
+                (mode, count, type, indices, draw_count, base_vertex), DRAW)                                                \
+    GL_FUNCTION(MultiDrawElementsIndirect, void,                                                                            \
+                (GLenum mode, GLenum type, const void* indirect, GLsizei draw_count, GLsizei stride),                       \
+                (mode, type, indirect, draw_count, stride), DRAW)                                                           \
+    GL_FUNCTION(PixelStorei, void, (GLenum pname, GLint param), (pname, param), STATE)                                      \
+    GL_FUNCTION(QueryCounter, void, (GLuint id, GLenum target), (id, target), CALL)                                         \
+    GL_FUNCTION(ReadPixels, void,                                                                                           \
+                (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels),                \
+                (x, y, width, height, format, type, pixels), CALL)                                                          \
+    GL_FUNCTION(RenderbufferStorage, void,                                                                                  \
+                (GLenum target, GLenum internalformat, GLsizei width, GLsizei height),                                      \
+                (target, internalformat, width, height), CALL)                                                              \
+    GL_FUNCTION(ShaderSource, void,                                                                                         \
+                (GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length),                           \
+                (shader, count, string, length), CALL)                                                                      \
+    GL_FUNCTION(TexImage2D, void,                                                                                           \
+                (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,                           \
+                 GLint border, GLenum format, GLenum type, const void* pixels),                                             \
+                (target, level, internalformat, width, height, border, format, type, pixels), UPLOAD)                       \
+    GL_FUNCTION(TexParameteri, void, (GLenum target, GLenum pname, GLint param), (target, pname, param), STATE)             \
+    GL_FUNCTION(TexSubImage2D, void,                                                                                        \
+                (GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height,                               \
+                 GLenum format, GLenum type, const void* pixels),                                                           \
+                (target, level, x, y, width, height, format, type, pixels), UPLOAD)                                         \
+    GL_FUNCTION(Uniform1i, void, (GLint location, GLint x), (location, x), UNIFORM)                                         \
+    GL_FUNCTION(Uniform3f, void, (GLint location, GLfloat x, GLfloat y, GLfloat z), (location, x, y, z), UNIFORM)           \
+    GL_FUNCTION(Uniform4f, void,                                                                                            \
+                (GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w),                                               \
+                (location, x, y, z, w), UNIFORM)                                                                            \
+    GL_FUNCTION(UnmapBuffer, GLboolean, (GLenum target), (target), CALL)                                                    \
+    GL_FUNCTION(UseProgram, void, (GLuint program), (program), STATE)                                                       \
+    GL_FUNCTION(ValidateProgram, void, (GLuint program), (program), CALL)                                                   \
+    GL_FUNCTION(VertexAttrib1f, void, (GLuint index, GLfloat x), (index, x), STATE)                                         \
+    GL_FUNCTION(VertexAttribDivisor, void, (GLuint index, GLuint divisor), (index, divisor), STATE)                         \
+    GL_FUNCTION(VertexAttribPointer, void,                                                                                  \
+                (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer),         \
+                (index, size, type, normalized, stride, pointer), STATE)                                                    \
+    GL_FUNCTION(Viewport, void, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), STATE)
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+#include "opengl/gl_functions.hpp"
+
+namespace GL {
+
+// Counters of one `gl()` or `gl_call()` call site, kept when the library
+// is built with the `gl_stats` option
+struct GLCallStats {
+    const char* file;
+    int line;
+    // The GL function, or the expression given to `gl_call()`
+    const char* call;
+
+    std::uint64_t calls = 0;
+    std::uint64_t nanoseconds = 0;
+    std::uint64_t bytes = 0;
+
+    // Since the last `end_gl_stats_frame()`
+    std::uint64_t frame_calls = 0;
+    std::uint64_t frame_nanoseconds = 0;
+    std::uint64_t frame_bytes = 0;
+};
+
+// Call sites register once, the first time they run. The counters are
+// never freed, so that they can still be reported at exit.
+GLCallStats* register_gl_call_site(const char* file, int line, const char* call);
+
+// Times the GL call made during its lifetime
+class GLCallTimer {
+private:
+    GLCallStats* m_stats;
+    std::size_t m_bytes;
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    GLCallTimer(GLCallStats* stats, std::size_t bytes)
+        : m_stats(stats)
+        , m_bytes(bytes)
+        , m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~GLCallTimer()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - m_start;
+        std::uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+        m_stats->calls += 1;
+        m_stats->nanoseconds += nanoseconds;
+        m_stats->bytes += m_bytes;
+        m_stats->frame_calls += 1;
+        m_stats->frame_nanoseconds += nanoseconds;
+        m_stats->frame_bytes += m_bytes;
+    }
+
+    GLCallTimer(const GLCallTimer&) = delete;
+    GLCallTimer& operator=(const GLCallTimer&) = delete;
+};
+
+// Bytes a call hands to GL, `gl_upload_size_<name>` takes the arguments of
+// gl<name>. Only uploads count, every other function reports 0.
+#define GL_UPLOAD_SIZE_CALL(name, params) \
+    inline std::size_t gl_upload_size_##name params { return 0; }
+#define GL_UPLOAD_SIZE_STATE GL_UPLOAD_SIZE_CALL
+#define GL_UPLOAD_SIZE_UNIFORM GL_UPLOAD_SIZE_CALL
+#define GL_UPLOAD_SIZE_DRAW GL_UPLOAD_SIZE_CALL
+#define GL_UPLOAD_SIZE_UPLOAD(name, params) \
+    std::size_t gl_upload_size_##name params;
+// Report 0 too, but keep track of the bindings uploads read from
+#define GL_UPLOAD_SIZE_BIND GL_UPLOAD_SIZE_UPLOAD
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#define GL_FUNCTION(name, return_type, params, args, kind) GL_UPLOAD_SIZE_##kind(name, params)
+GL_FUNCTIONS
+#undef GL_FUNCTION
+#pragma GCC diagnostic pop
+
+// Writes the call sites used since the last call, by time spent, and
+// resets their frame counters. `out` may be nullptr to only reset them.
+void end_gl_stats_frame(std::ostream* out);
+
+// Writes the `count` call sites that spent the most time in GL. Done on
+// std::cerr at exit with the `gl_stats` option.
+void print_gl_stats(std::ostream& out, std::size_t count);
+
+}
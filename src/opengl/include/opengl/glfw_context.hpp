@@ -0,0 +1,35 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include "opengl/context.hpp"
+
+namespace GL {
+
+// A GLFW window, its framebuffer size follows the window size
+class GlfwContext : public Context {
+private:
+    GLFWwindow* m_window = nullptr;
+
+    static void on_framebuffer_resize(GLFWwindow* window, int width, int height);
+
+public:
+    GlfwContext(const ContextConfig& config);
+    ~GlfwContext();
+
+    GlfwContext(const GlfwContext&) = delete;
+    GlfwContext& operator=(const GlfwContext&) = delete;
+
+    bool is_valid() const { return m_window != nullptr; }
+
+    bool is_headless() const override { return false; }
+    bool should_close() const override;
+    void swap_buffers() override;
+    void poll_events() override;
+    GLuint framebuffer() const override { return 0; }
+
+    // For input callbacks
+    GLFWwindow* window() const { return m_window; }
+};
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace GL {
+
+enum class GpuResourceType {
+    VERTEX_BUFFER,
+    INDEX_BUFFER,
+    STORAGE_BUFFER,
+    // Indirect draw commands and draw ids
+    INDIRECT_BUFFER,
+    // Pixel unpack buffers texture updates are staged through
+    STAGING_BUFFER,
+    TEXTURE,
+    COUNT,
+};
+
+const char* gpu_resource_type_name(GpuResourceType type);
+
+struct GpuMemoryUsage {
+    // Live bytes, as requested from GL. The driver adds padding and
+    // alignment on top.
+    std::size_t bytes = 0;
+    std::size_t peak = 0;
+    // Bytes freed by reallocations, storage thrown away only to allocate
+    // a bigger one in its place
+    std::size_t churn = 0;
+};
+
+// Called by the library when GL storage is created, deleted or replaced.
+// Resources with an empty label only count towards their type.
+void track_gpu_allocation(GpuResourceType type, const std::string& label, std::size_t bytes);
+void track_gpu_free(GpuResourceType type, const std::string& label, std::size_t bytes);
+void track_gpu_reallocation(GpuResourceType type, const std::string& label,
+                            std::size_t old_bytes, std::size_t new_bytes);
+// Moves live bytes to another label, when a resource is labelled
+void track_gpu_relabel(const std::string& old_label, const std::string& new_label, std::size_t bytes);
+
+GpuMemoryUsage gpu_memory_usage();
+GpuMemoryUsage gpu_memory_usage(GpuResourceType type);
+// Of labelled resources, sorted by label
+std::vector<std::pair<std::string, GpuMemoryUsage>> gpu_memory_usage_by_label();
+
+// Writes an error on std::cerr when the live bytes of every resource, or
+// of one type, cross `bytes`. Only writes again once usage went back
+// under the budget. 0 removes the budget.
+void set_gpu_memory_budget(std::size_t bytes);
+void set_gpu_memory_budget(GpuResourceType type, std::size_t bytes);
+
+// What the driver reports, in bytes, through GL_NVX_gpu_memory_info or
+// GL_ATI_meminfo. Fields the extension does not cover are 0.
+struct GpuDriverMemory {
+    // GL_NVX_gpu_memory_info only
+    std::size_t dedicated = 0;
+    std::size_t total_available = 0;
+    // Video memory free right now, for GL_ATI_meminfo that of the texture
+    // pool
+    std::size_t available = 0;
+    // GL_ATI_meminfo only, free memory of the vertex buffer pool
+    std::size_t buffer_available = 0;
+};
+
+// Returns false when neither extension is supported
+bool query_gpu_driver_memory(GpuDriverMemory& memory);
+
+// Writes the usage per type and per label, and what the driver reports
+void print_gpu_memory(std::ostream& out);
+
+}
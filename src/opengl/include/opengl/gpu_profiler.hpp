@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace GL {
+
+// Frames recorded before the oldest one is read back, reading only blocks
+// when the GPU is further behind than that
+#define GPU_PROFILER_FRAME_COUNT 4
+
+#define GPU_ZONE_NO_PARENT static_cast<std::size_t>(-1)
+
+struct GpuZone {
+    // Zone names are not copied, they must outlive the profiler
+    const char* name;
+    // Index of the enclosing zone in the frame, GPU_ZONE_NO_PARENT for top
+    // level zones
+    std::size_t parent;
+    unsigned int depth;
+    // Nanoseconds on the GPU timeline
+    GLuint64 start;
+    GLuint64 end;
+
+    double milliseconds() const { return (end - start) / 1e6; }
+};
+
+// A zone's GPU times over the last frames of the profiler's window, zones
+// are told apart by their path, "frame/draws" for example
+struct GpuZoneStats {
+    std::string path;
+    std::size_t samples;
+    double min;
+    double average;
+    double max;
+};
+
+// Measures GPU time per zone with GL_TIMESTAMP queries written at both
+// ends of each zone, which unlike GL_TIME_ELAPSED queries can be nested.
+// The queries of a frame are read back GPU_PROFILER_FRAME_COUNT frames
+// later at most, without waiting when the GPU has caught up.
+//
+// Must be used from the GL thread, between `begin_frame()` and
+// `end_frame()`. While a trace is recorded the zones are added to it too,
+// see `start_trace()`.
+class GpuProfiler {
+private:
+    struct Frame {
+        long number = -1;
+        bool pending = false;
+        // Two per zone, its start then its end
+        std::vector<GLuint> queries;
+        std::vector<GpuZone> zones;
+        // Added to the frame's GPU timestamps to place them on the trace
+        // timeline, 0 when the frame was not traced
+        std::int64_t trace_offset = 0;
+    };
+
+    struct ZoneHistory {
+        std::string path;
+        // Ring of the last `m_window` durations, in milliseconds
+        std::vector<double> samples;
+        std::size_t next = 0;
+    };
+
+    bool m_supported;
+    std::size_t m_window;
+
+    Frame m_frames[GPU_PROFILER_FRAME_COUNT];
+    long m_frame_number = -1;
+    bool m_in_frame = false;
+    std::vector<std::size_t> m_open_zones;
+
+    std::vector<GpuZone> m_last_frame;
+    long m_last_frame_number = -1;
+    std::vector<ZoneHistory> m_history;
+
+    Frame& current_frame() { return m_frames[m_frame_number % GPU_PROFILER_FRAME_COUNT]; }
+    bool read_frame(Frame& frame, bool wait);
+    void record_history(const std::vector<GpuZone>& zones);
+
+public:
+    // Stats cover the last `window` frames
+    GpuProfiler(std::size_t window = 120);
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // Timer queries need OpenGL 3.3 or GL_ARB_timer_query, without them
+    // every call does nothing
+    bool is_supported() const { return m_supported; }
+
+    // Reads back the frames the GPU is done with, then starts recording a
+    // new one
+    void begin_frame();
+    void end_frame();
+
+    void begin_zone(const char* name);
+    void end_zone();
+
+    // Zones of the latest frame read back, in the order they began, so
+    // that every zone comes after its parent
+    const std::vector<GpuZone>& last_frame() const { return m_last_frame; }
+    long last_frame_number() const { return m_last_frame_number; }
+
+    std::vector<GpuZoneStats> stats() const;
+};
+
+// Measures the GPU time of the commands issued during its lifetime
+class GpuZoneScope {
+private:
+    GpuProfiler& m_profiler;
+
+public:
+    GpuZoneScope(GpuProfiler& profiler, const char* name)
+        : m_profiler(profiler)
+    {
+        m_profiler.begin_zone(name);
+    }
+
+    ~GpuZoneScope() { m_profiler.end_zone(); }
+
+    GpuZoneScope(const GpuZoneScope&) = delete;
+    GpuZoneScope& operator=(const GpuZoneScope&) = delete;
+};
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "opengl/texture.hpp"
+
+namespace GL {
+
+// Decoded pixels, tightly packed in `format`. The pixels start `offset`
+// bytes into `buffer`, which lets decoders of pre-decoded formats hand out
+// the file contents as is instead of copying them.
+struct Image {
+    std::vector<unsigned char> buffer;
+    std::size_t offset = 0;
+    std::size_t width = 0;
+    std::size_t height = 0;
+    PixelFormat format = PixelFormat::R8G8B8A8;
+
+    bool is_valid() const { return buffer.size() > offset; }
+    std::size_t byte_size() const { return buffer.size() - offset; }
+
+    unsigned char* pixels() { return buffer.data() + offset; }
+    const unsigned char* pixels() const { return buffer.data() + offset; }
+};
+
+// Pixels owned by someone else, e.g. a memory mapped file
+struct ImageView {
+    const unsigned char* pixels = nullptr;
+    std::size_t width = 0;
+    std::size_t height = 0;
+    PixelFormat format = PixelFormat::R8G8B8A8;
+};
+
+struct ImageDecoder {
+    const char* name;
+    // Whether `data` looks like something this decoder understands
+    bool (*probe)(const unsigned char* data, std::size_t size);
+    // Decodes `bytes`, which it is free to reuse as the image's buffer.
+    // Returns an invalid image on failure.
+    Image (*decode)(std::vector<unsigned char>&& bytes, bool flip_vertically);
+};
+
+// Built-in decoders, tried in this order before falling back to stb_image
+extern const ImageDecoder raw_image_decoder;
+extern const ImageDecoder qoi_image_decoder;
+extern const ImageDecoder tga_image_decoder;
+
+// Registers a decoder that is tried before the built-in ones. Not thread
+// safe, register decoders before any image is loaded.
+void register_image_decoder(const ImageDecoder& decoder);
+
+// Decodes `bytes` with the first decoder whose probe accepts them. Images
+// decoded by stb_image, QOI and TGA images come out as R8G8B8A8, raw images
+// keep the format they were stored in. Safe to call from any thread, it
+// does not touch the OpenGL context.
+Image decode_image(std::vector<unsigned char>&& bytes, bool flip_vertically);
+Image load_image(const std::string& path, bool flip_vertically);
+
+// Serializes `image` into the raw format read by `raw_image_decoder`,
+// which loads at memcpy speed
+std::vector<unsigned char> encode_raw_image(const Image& image);
+// Points `view` at the pixels of raw image `data` without copying them.
+// Returns false if `data` is not a valid raw image.
+bool view_raw_image(const unsigned char* data, std::size_t size, ImageView& view);
+
+// Reads a whole file into memory, returns false if it could not be read
+bool read_file(const std::string& path, std::vector<unsigned char>& bytes);
+
+}
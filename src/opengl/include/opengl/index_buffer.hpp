@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstddef>
+#include <string>
 
 #include <GL/glew.h>
 
@@ -13,18 +14,33 @@ private:
     std::size_t m_index_count = 0;
     std::size_t m_index_capacity = 0;
 
+    std::string m_label;
+
 public:
     IndexBuffer();
     ~IndexBuffer();
 
+    // Names the buffer in the GPU memory accounting, see `print_gpu_memory()`
+    void set_label(const std::string& label);
+    const std::string& label() const { return m_label; }
+
+    GLuint id() const { return m_id; }
+
     void bind() const;
     void unbind() const;
 
     void clear() { m_index_count = 0; };
     void resize(std::size_t added_indices);
     void push_index(GLuint index);
+    void push_indices(const GLuint* indices, std::size_t count);
 
     std::size_t index_count() { return m_index_count; }
+
+    // Draws `index_count` indices starting at `first_index`, with
+    // `base_vertex` added to each of them. The vertex array holding this
+    // buffer must be bound.
+    void draw(GLenum mode, std::size_t first_index, std::size_t index_count,
+              GLint base_vertex = 0) const;
 };
 
 }
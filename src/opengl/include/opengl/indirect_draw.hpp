@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace GL {
+
+// The record glMultiDrawElementsIndirect reads from the indirect buffer
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+};
+
+// Collects indexed draws that share the bound vertex array and submits them
+// in a single call. With OpenGL 4.3 or GL_ARB_multi_draw_indirect the
+// commands go through an indirect buffer, otherwise through
+// glMultiDrawElementsBaseVertex.
+//
+// Shaders can tell the draws apart through a per-instance draw id
+// attribute, see `enable_draw_id()`.
+class IndirectDrawBuilder {
+private:
+    GLuint m_indirect_buffer = 0;
+    std::size_t m_indirect_capacity = 0;
+
+    // Holds 0, 1, 2... read through the draw id attribute, each command
+    // starts reading at its own index through its base instance
+    GLuint m_draw_id_buffer = 0;
+    std::size_t m_draw_id_capacity = 0;
+    GLint m_draw_id_location = -1;
+
+    bool m_indirect_supported;
+
+    std::vector<DrawElementsIndirectCommand> m_commands;
+
+    // Fallback arrays for glMultiDrawElementsBaseVertex
+    std::vector<GLsizei> m_counts;
+    std::vector<const void*> m_offsets;
+    std::vector<GLint> m_base_vertices;
+
+    void reserve_draw_ids(std::size_t count);
+
+public:
+    IndirectDrawBuilder();
+    ~IndirectDrawBuilder();
+
+    IndirectDrawBuilder(const IndirectDrawBuilder&) = delete;
+    IndirectDrawBuilder& operator=(const IndirectDrawBuilder&) = delete;
+
+    // Feeds the index of each draw to the float attribute at `location` of
+    // the bound vertex array
+    void enable_draw_id(GLuint location);
+
+    // `first_index` and `index_count` are in GLuint indices of the bound
+    // index buffer, `base_vertex` is added to every index
+    void add(GLuint first_index, GLuint index_count, GLint base_vertex = 0);
+
+    // Draws every command with the bound vertex array and index buffer
+    void submit(GLenum mode = GL_TRIANGLES);
+    void clear();
+
+    std::size_t command_count() const { return m_commands.size(); }
+    bool is_indirect_supported() const { return m_indirect_supported; }
+};
+
+}
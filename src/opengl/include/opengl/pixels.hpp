@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+namespace GL {
+
+// Pixel conversion kernels. Each one has a scalar version and SSE2, SSSE3,
+// AVX2 or NEON versions where they pay off; the best one the CPU supports
+// is picked at runtime on first use.
+
+// Expands R8G8B8 pixels to R8G8B8A8 with an opaque alpha. `src` and `dst`
+// must not overlap.
+void expand_rgb_to_rgba(const unsigned char* src, unsigned char* dst,
+                        std::size_t pixel_count);
+
+// Multiplies the color channels of R8G8B8A8 pixels by their alpha, in place
+void premultiply_alpha(unsigned char* pixels, std::size_t pixel_count);
+
+// Swaps the red and blue channels of 4 byte pixels in place, which turns
+// RGBA into BGRA and back
+void swizzle_rgba_to_bgra(unsigned char* pixels, std::size_t pixel_count);
+
+// Converts the color channels of R8G8B8A8 pixels between sRGB and linear
+// encoding. Alpha is always linear and is only rescaled to [0, 1].
+void srgb_to_linear(const unsigned char* src, float* dst, std::size_t pixel_count);
+void linear_to_srgb(const float* src, unsigned char* dst, std::size_t pixel_count);
+
+// Reverses the order of `row_count` rows of `row_size` bytes, in place
+void flip_rows(unsigned char* pixels, std::size_t row_size, std::size_t row_count);
+
+// Name of the kernel set in use, e.g. "avx2"
+const char* pixel_kernels_name();
+
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "opengl/index_buffer.hpp"
+#include "opengl/indirect_draw.hpp"
+#include "opengl/shader.hpp"
+#include "opengl/texture.hpp"
+#include "opengl/vertex_array.hpp"
+
+namespace GL {
+
+struct RenderItem {
+    // Lower layers are drawn first, at most 255
+    unsigned int layer;
+    // Translucent items are drawn after the opaque ones of their layer, in
+    // submission order and with blending enabled
+    bool translucent;
+    // In [0, 1], opaque items of a layer with the same state are drawn
+    // roughly front to back, depth is only kept to 1/2048
+    float depth;
+
+    Shader* shader;
+    // Bound to slot 0
+    const Texture* texture;
+    const VertexArray* vertex_array;
+    const IndexBuffer* index_buffer;
+
+    GLenum mode;
+    std::size_t first_index;
+    std::size_t index_count;
+    GLint base_vertex;
+};
+
+struct RenderQueueStats {
+    std::size_t items = 0;
+    std::size_t draw_calls = 0;
+    std::size_t shader_binds = 0;
+    std::size_t texture_binds = 0;
+    std::size_t vertex_array_binds = 0;
+    std::size_t blend_changes = 0;
+};
+
+// Collects the draws of a frame and submits them sorted by 64 bit keys, so
+// that items sharing a shader, texture and geometry go out together. Runs
+// of items with the same state are merged into one multi draw.
+//
+// Key layout, most significant bit first:
+//   8 bits  layer
+//   1 bit   translucent
+//   opaque:      12 bits shader, 16 bits texture, 8 bits vertex array,
+//                8 bits index buffer, 11 bits depth
+//   translucent: 55 bits submission order
+class RenderQueue {
+private:
+    std::vector<RenderItem> m_items;
+    std::vector<std::uint64_t> m_keys;
+    std::vector<std::uint32_t> m_order;
+    std::vector<std::uint32_t> m_scratch;
+
+    IndirectDrawBuilder m_draws;
+    RenderQueueStats m_stats;
+
+public:
+    static std::uint64_t sort_key(const RenderItem& item, std::uint64_t sequence);
+
+    void push(const RenderItem& item);
+
+    // Sorts and draws every pushed item, then empties the queue. Leaves
+    // the last shader, texture and vertex array bound, the GL_ARRAY_BUFFER
+    // binding is kept.
+    void submit();
+
+    // Lets vertex arrays take the index of each draw within its multi draw
+    // as an attribute, see `IndirectDrawBuilder::enable_draw_id()`
+    IndirectDrawBuilder& draws() { return m_draws; }
+
+    // Of the last `submit()`
+    const RenderQueueStats& stats() const { return m_stats; }
+    std::size_t size() const { return m_items.size(); }
+};
+
+}
@@ -1,34 +1,87 @@
 #pragma once
 
+#include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include <GL/glew.h>
 
 namespace GL {
 
+struct PendingProgram;
+
+// A uniform's location and the last value set through it, which lets
+// setting the same value again skip the GL call
+struct UniformState {
+    int location;
+    // GL_NONE until a value is set
+    GLenum type = GL_NONE;
+    float values[4];
+    int integer;
+};
+
+// Lets uniforms be looked up by a string_view without building a string
+struct UniformNameHash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+};
+
 class Shader {
-private:
+protected:
     GLuint m_id;
     bool m_valid = true;
+    std::string m_name;
+
+private:
+    PendingProgram* m_pending = nullptr;
 
-    std::unordered_map<std::string, int> m_locations;
+    // Cleared when the program is swapped by a reload, which resets the
+    // values of its uniforms
+    std::unordered_map<std::string, UniformState, UniformNameHash, std::equal_to<>> m_uniforms;
 
-    int get_uniform_location(const std::string& name);
+    UniformState& get_uniform(std::string_view name);
 
 public:
+    // Shader files hold one or more stages, each introduced by a
+    // `#shader vertex|fragment|geometry|compute` line. Compute stages can
+    // not be combined with other stages.
     Shader(const std::string& path);
+    // Builds the shader from the contents of a shader file, `name` is only
+    // used for error messages
+    Shader(const std::string& name, std::string_view source);
+    virtual ~Shader();
+
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
 
     bool is_valid() const { return m_valid; };
+    GLuint id() const { return m_id; }
+    // The path of the shader file, or the name it was built with
+    const std::string& name() const { return m_name; }
+
+    // Starts rebuilding the shader from new source without waiting for the
+    // driver. The current program stays in use until `finish_reload()`
+    // swaps it, and is kept if the new source fails to build.
+    void reload(std::string_view source);
+    // Swaps in the reloaded program once the driver is done building it,
+    // meant to be called between frames. Returns true when the program
+    // changed, its uniforms then have to be set again.
+    bool finish_reload();
+    void cancel_reload();
+    bool is_reloading() const { return m_pending != nullptr; }
 
     void bind() const;
     void unbind() const;
 
-    void set_uniform(const std::string& name,
+    // Set on the bound program, which has to be this one. Values are
+    // cached per shader, uniforms must not be set on its program directly.
+    void set_uniform(std::string_view name,
                      float x, float y, float z, float w);
-    void set_uniform(const std::string& name,
+    void set_uniform(std::string_view name,
                      float x, float y, float z);
-    void set_uniform(const std::string& name, int x);
+    void set_uniform(std::string_view name, int x);
 };
 
 }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "opengl/shader.hpp"
+
+namespace GL {
+
+// Reloads shaders when their source file changes. Files are watched with
+// inotify and read on a background thread, while the rebuilt programs are
+// compiled without blocking and swapped in by `update()` on the GL thread.
+// Only available on Linux.
+class ShaderWatcher {
+private:
+    struct Watch {
+        Shader* shader;
+        std::string path;
+        // Files are watched through their directory, so that editors which
+        // replace the file instead of writing to it are noticed too
+        int directory;
+        std::string file_name;
+    };
+
+    struct Change {
+        Shader* shader;
+        std::string source;
+    };
+
+    int m_inotify = -1;
+    // Closing the write end wakes up and stops the watch thread
+    int m_wake[2] = { -1, -1 };
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+    std::vector<Watch> m_watches;
+    std::vector<Change> m_changes;
+
+    // Only touched from the GL thread
+    std::vector<Shader*> m_reloading;
+
+    void watch_loop();
+
+public:
+    // Must be created on the GL thread, it enables the driver's parallel
+    // shader compilation when available
+    ShaderWatcher();
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    bool is_valid() const { return m_inotify != -1; }
+
+    // Reloads `shader` whenever `path` changes, shaders that did not come
+    // from a file can be watched against their source file this way
+    bool watch(Shader* shader, const std::string& path);
+    bool watch(Shader* shader) { return watch(shader, shader->name()); }
+    void unwatch(Shader* shader);
+
+    // Starts rebuilding the shaders whose file changed and swaps in those
+    // the driver is done with, meant to be called once per frame between
+    // frames. Returns true when any shader was swapped.
+    bool update();
+};
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "opengl/vertex_buffer.hpp"
+
+namespace GL {
+
+// A buffer shaders read and write through `buffer` blocks. The same buffer
+// can feed a vertex array, so a compute shader can generate vertices.
+class ShaderStorageBuffer {
+private:
+    GLuint m_id;
+    GLenum m_usage;
+
+    std::size_t m_size = 0;
+    std::size_t m_capacity = 0;
+
+    std::string m_label;
+
+public:
+    ShaderStorageBuffer(GLenum usage = GL_DYNAMIC_DRAW);
+    ~ShaderStorageBuffer();
+
+    ShaderStorageBuffer(const ShaderStorageBuffer&) = delete;
+    ShaderStorageBuffer& operator=(const ShaderStorageBuffer&) = delete;
+
+    // Names the buffer in the GPU memory accounting, see `print_gpu_memory()`
+    void set_label(const std::string& label);
+    const std::string& label() const { return m_label; }
+
+    void bind() const;
+    void unbind() const;
+    // Binds the buffer to the `layout(binding = index)` of the shaders
+    void bind_base(GLuint index) const;
+    // Uses the buffer as the vertex buffer of the bound vertex array
+    void bind_vertices(const VertexLayout& layout) const;
+
+    // Makes room for `size` bytes, the contents are lost when the buffer
+    // has to grow
+    void reserve(std::size_t size);
+    // Replaces the contents of the buffer
+    void upload(const void* data, std::size_t size);
+
+    std::size_t size() const { return m_size; }
+    GLuint id() const { return m_id; }
+};
+
+}
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
 #include <GL/glew.h>
 
 namespace GL {
@@ -12,20 +17,96 @@ enum class TextureType {
 enum class PixelFormat {
     R8G8B8A8,
     R8G8B8,
+    R8,
+    R8G8,
+    R16G16B16A16F,
+    R11G11B10F,
+    SRGB8_ALPHA8,
+
+    DEPTH24,
+    DEPTH32F,
+    DEPTH24_STENCIL8,
+
+    // Block-compressed formats, 4x4 pixel blocks
+    BC1_RGBA,
+    BC3_RGBA,
+    BC7_RGBA,
+    ETC2_RGBA8,
+};
+
+bool is_compressed(PixelFormat format);
+bool is_pixel_format_supported(PixelFormat format);
+
+// Size in bytes of a `width` x `height` level stored in `format`
+std::size_t level_size(PixelFormat format, std::size_t width, std::size_t height);
+
+// One mip level of pixel data, level 0 being the largest
+struct TextureLevel {
+    const unsigned char* data;
+    std::size_t size;
+    std::size_t width;
+    std::size_t height;
 };
 
+#define TEXTURE_UPLOAD_RING_SIZE 3
+
 class Texture {
 private:
+    // A pixel unpack buffer together with the fence of the last upload
+    // that read from it
+    struct UploadSlot {
+        GLuint buffer = 0;
+        std::size_t capacity = 0;
+        GLsync fence = nullptr;
+    };
+
     GLuint m_id;
     TextureType m_type;
+    PixelFormat m_pixel_format;
+
+    std::size_t m_width;
+    std::size_t m_height;
+    // Of every level, as accounted for by the GPU memory tracker
+    std::size_t m_size = 0;
+    std::string m_label;
+
+    std::array<UploadSlot, TEXTURE_UPLOAD_RING_SIZE> m_upload_ring;
+    std::size_t m_upload_slot = 0;
 
 public:
-    Texture(unsigned char* pixels, std::size_t width, std::size_t height,
+    Texture(const unsigned char* pixels, std::size_t width, std::size_t height,
+            PixelFormat pixel_format, TextureType type);
+    // Uploads a full or partial mip chain, with compressed formats uploaded
+    // as is through glCompressedTexImage2D
+    Texture(const std::vector<TextureLevel>& levels,
             PixelFormat pixel_format, TextureType type);
     ~Texture();
 
+    // Textures own their GL name, so they can be moved but not copied
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+    Texture(Texture&& other);
+    Texture& operator=(Texture&& other);
+
     void bind(GLuint slot) const;
     void unbind() const;
+
+    // Names the texture and its staging buffers in the GPU memory
+    // accounting, see `print_gpu_memory()`
+    void set_label(const std::string& label);
+    const std::string& label() const { return m_label; }
+
+    // Replaces a region of the texture with `pixels`, laid out in the
+    // texture's pixel format. The pixels are staged through a ring of
+    // pixel unpack buffers, so the copy to the texture happens on the GPU
+    // timeline and does not stall on draws still reading the texture.
+    void update_region(std::size_t x, std::size_t y,
+                       std::size_t width, std::size_t height,
+                       const unsigned char* pixels);
+
+    GLuint id() const { return m_id; }
+    std::size_t width() const { return m_width; }
+    std::size_t height() const { return m_height; }
 };
 
 void set_magnification_filter(GLenum filter);
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "opengl/texture.hpp"
+
+namespace GL {
+
+class TextureCache;
+
+// Counted reference to a cached texture. References are move-only, another
+// reference to the same texture is obtained through `share()`. The texture
+// is evicted from the cache once its last reference is destroyed.
+class TextureRef {
+private:
+    TextureCache* m_cache = nullptr;
+    std::uint64_t m_key = 0;
+    const Texture* m_texture = nullptr;
+
+    friend class TextureCache;
+    TextureRef(TextureCache* cache, std::uint64_t key, const Texture* texture);
+
+public:
+    TextureRef() = default;
+    ~TextureRef();
+
+    TextureRef(const TextureRef&) = delete;
+    TextureRef& operator=(const TextureRef&) = delete;
+    TextureRef(TextureRef&& other);
+    TextureRef& operator=(TextureRef&& other);
+
+    TextureRef share() const;
+
+    bool is_valid() const { return m_texture != nullptr; }
+
+    const Texture& operator*() const { return *m_texture; }
+    const Texture* operator->() const { return m_texture; }
+    const Texture* get() const { return m_texture; }
+};
+
+struct TextureCacheStats {
+    // Requests served by an already uploaded texture, found by path or by
+    // content hash
+    std::size_t path_hits = 0;
+    std::size_t content_hits = 0;
+    // Requests that had to decode and upload
+    std::size_t misses = 0;
+    std::size_t evictions = 0;
+};
+
+// Deduplicates texture loads by path and by the hash of the file contents,
+// so every distinct image is decoded and uploaded once. Must only be used
+// from the GL thread.
+class TextureCache {
+private:
+    struct Entry {
+        Texture* texture;
+        std::size_t reference_count;
+        std::vector<std::string> paths;
+        // Of the file contents. On a hash hit of the same size, the file is
+        // read again from its first path and compared, so that a collision
+        // does not hand out another texture.
+        std::size_t size;
+    };
+
+    bool m_flip_vertically;
+
+    std::unordered_map<std::string, std::uint64_t> m_keys_by_path;
+    std::unordered_map<std::uint64_t, Entry> m_entries;
+
+    TextureCacheStats m_stats;
+
+    friend class TextureRef;
+    void retain(std::uint64_t key);
+    void release(std::uint64_t key);
+
+    TextureRef reference(std::uint64_t key);
+
+public:
+    TextureCache(bool flip_vertically);
+    ~TextureCache();
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Returns an invalid reference if the file could not be read or decoded
+    TextureRef load(const std::string& path);
+
+    std::size_t size() const { return m_entries.size(); }
+    const TextureCacheStats& stats() const { return m_stats; }
+};
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Marks the rest of the enclosing block as a CPU zone of the trace. With
+// the `trace` option off it expands to nothing.
+#ifdef OPENGL_TRACE
+#define trace_scope_concat(a, b) a##b
+#define trace_scope_name(line) trace_scope_concat(trace_scope_, line)
+#define trace_scope(name) GL::TraceScope trace_scope_name(__LINE__)(name)
+#else
+#define trace_scope(name)
+#endif
+
+namespace GL {
+
+// Starts recording CPU zones and the GPU zones of every GpuProfiler into
+// a trace written by `stop_trace()`, in the Chrome trace event format
+// read by chrome://tracing and Perfetto. Returns false when the library
+// was built without the `trace` option.
+bool start_trace(const std::string& path);
+void stop_trace();
+bool is_tracing();
+
+// Nanoseconds on the steady clock, the timeline of the trace
+std::int64_t trace_clock();
+
+// Zone names are not copied, they must outlive the trace
+void trace_cpu_zone(const char* name, std::int64_t start, std::int64_t end);
+void trace_gpu_zone(const char* name, std::int64_t start, std::int64_t end);
+
+class TraceScope {
+private:
+    const char* m_name;
+    std::int64_t m_start;
+
+public:
+    TraceScope(const char* name)
+        : m_name(name)
+        , m_start(is_tracing() ? trace_clock() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (m_start != 0 && is_tracing())
+            trace_cpu_zone(m_name, m_start, trace_clock());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+}
@@ -20,6 +20,8 @@ public:
     VertexArray();
     ~VertexArray();
 
+    GLuint id() const { return m_id; }
+
     void bind() const;
     void unbind() const;
 
@@ -27,6 +29,12 @@ public:
 
     VertexBuffer* bind_vertex_buffer(const VertexLayout& layout);
     IndexBuffer* bind_index_buffer();
+
+    // Binds the vertex array and draws a range of `index_buffer`, see
+    // `IndexBuffer::draw()`
+    void draw(const IndexBuffer& index_buffer, GLenum mode,
+              std::size_t first_index, std::size_t index_count,
+              GLint base_vertex = 0) const;
 };
 
 }
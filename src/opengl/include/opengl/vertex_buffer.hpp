@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <iostream>
+#include <string>
 #include <typeinfo>
 #include <vector>
 
@@ -30,6 +31,10 @@ struct VertexAttributeComponent {
             component.type = GL_UNSIGNED_BYTE;
             component.size = sizeof(GLubyte);
 
+        } else if (typeid(T) == typeid(unsigned int)) {
+            component.type = GL_UNSIGNED_INT;
+            component.size = sizeof(GLuint);
+
         } else {
             std::cerr << "FATAL ERROR: invalid attribute component `"
                       << typeid(T).name() << "`\n";
@@ -45,6 +50,8 @@ struct VertexAttribute {
     VertexAttributeComponent component;
     std::size_t component_count;
     std::size_t offset;
+    // 0 advances the attribute per vertex, N per N instances
+    GLuint divisor;
 };
 
 struct VertexLayout {
@@ -52,7 +59,7 @@ struct VertexLayout {
     std::size_t stride = 0;
 
     template <typename T>
-    void add_attribute(std::size_t count, bool normalized)
+    void add_attribute(std::size_t count, bool normalized, GLuint divisor = 0)
     {
         auto component = VertexAttributeComponent::from_type<T>();
 
@@ -61,11 +68,16 @@ struct VertexLayout {
             .component = component,
             .component_count = count,
             .offset = stride,
+            .divisor = divisor,
         };
 
         stride += count * component.size;
         attributes.push_back(attribute);
     }
+
+    // Points the attributes of the bound vertex array at the buffer bound
+    // to GL_ARRAY_BUFFER, starting at `first_location`
+    void apply(GLuint first_location = 0) const;
 };
 
 class VertexBuffer {
@@ -76,18 +88,27 @@ private:
     std::size_t m_size = 0;
     std::size_t m_capacity = 0;
 
+    std::string m_label;
+
 public:
     VertexBuffer(const VertexLayout& layout);
     ~VertexBuffer();
 
+    // Names the buffer in the GPU memory accounting, see `print_gpu_memory()`
+    void set_label(const std::string& label);
+    const std::string& label() const { return m_label; }
+
     void bind() const;
     void unbind() const;
 
     void clear() { m_size = 0; };
     void resize(std::size_t added_size);
     void push_vertex(const void* data, std::size_t data_size);
+    // Appends `count` vertices laid out back to back with the layout stride
+    void push_vertices(const void* data, std::size_t count);
 
     std::size_t vertex_count() { return m_size / m_layout.stride; }
+    const VertexLayout& layout() const { return m_layout; }
 
     void set_attribute(int vertex_index, int attribute_index,
                        const void* data, std::size_t data_size);
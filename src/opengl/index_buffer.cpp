@@ -2,7 +2,10 @@
 
 #include <cstring>
 
+#include "opengl/frame_stats.hpp"
 #include "opengl/gl_errors.hpp"
+#include "opengl/gpu_memory.hpp"
+#include "opengl/trace.hpp"
 
 namespace GL {
 
@@ -14,6 +17,14 @@ IndexBuffer::IndexBuffer()
 IndexBuffer::~IndexBuffer()
 {
     gl(DeleteBuffers, (1, &m_id));
+
+    track_gpu_free(GpuResourceType::INDEX_BUFFER, m_label, m_index_capacity * sizeof(unsigned int));
+}
+
+void IndexBuffer::set_label(const std::string& label)
+{
+    track_gpu_relabel(m_label, label, m_index_capacity * sizeof(unsigned int));
+    m_label = label;
 }
 
 void IndexBuffer::bind() const
@@ -28,6 +39,8 @@ void IndexBuffer::unbind() const
 
 void IndexBuffer::resize(std::size_t added_indices)
 {
+    trace_scope("IndexBuffer::resize");
+
     auto added_size = added_indices * sizeof(unsigned int);
 
     auto old_size = m_index_capacity * sizeof(unsigned int);
@@ -43,7 +56,11 @@ void IndexBuffer::resize(std::size_t added_indices)
     delete[] old_data;
     delete[] new_data;
 
+    track_gpu_reallocation(GpuResourceType::INDEX_BUFFER, m_label, old_size, new_size);
     m_index_capacity = new_size / sizeof(unsigned int);
+
+    frame_stats().buffer_reallocations += 1;
+    frame_stats().buffer_bytes_uploaded += new_size;
 }
 
 void IndexBuffer::push_index(GLuint index)
@@ -57,6 +74,40 @@ void IndexBuffer::push_index(GLuint index)
     gl(BufferSubData, (GL_ELEMENT_ARRAY_BUFFER, m_index_count * sizeof(unsigned int), added_index_count * sizeof(unsigned int), &index));
 
     m_index_count += added_index_count;
+
+    frame_stats().indices += added_index_count;
+    frame_stats().buffer_bytes_uploaded += added_index_count * sizeof(unsigned int);
+}
+
+void IndexBuffer::push_indices(const GLuint* indices, std::size_t count)
+{
+    trace_scope("IndexBuffer::push_indices");
+
+    if ((m_index_count + count) > m_index_capacity) {
+        resize(m_index_count + count - m_index_capacity);
+    }
+
+    gl(BufferSubData, (GL_ELEMENT_ARRAY_BUFFER, m_index_count * sizeof(unsigned int), count * sizeof(unsigned int), indices));
+
+    m_index_count += count;
+
+    frame_stats().indices += count;
+    frame_stats().buffer_bytes_uploaded += count * sizeof(unsigned int);
+}
+
+void IndexBuffer::draw(GLenum mode, std::size_t first_index, std::size_t index_count,
+                       GLint base_vertex) const
+{
+    const void* offset = reinterpret_cast<const void*>(first_index * sizeof(GLuint));
+
+    if (base_vertex == 0) {
+        gl(DrawElements, (mode, index_count, GL_UNSIGNED_INT, offset));
+    } else {
+        gl(DrawElementsBaseVertex, (mode, index_count, GL_UNSIGNED_INT, offset, base_vertex));
+    }
+
+    frame_stats().draw_calls += 1;
+    frame_stats().indices_drawn += index_count;
 }
 
 }
@@ -0,0 +1,170 @@
+#include "opengl/indirect_draw.hpp"
+
+#include <algorithm>
+
+#include "opengl/frame_stats.hpp"
+#include "opengl/gl_errors.hpp"
+#include "opengl/gpu_memory.hpp"
+#include "opengl/trace.hpp"
+
+namespace GL {
+
+IndirectDrawBuilder::IndirectDrawBuilder()
+{
+    // Non zero base instances need GL_ARB_base_instance on top of the
+    // multi draw extension
+    m_indirect_supported = GLEW_VERSION_4_3
+        || (GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance);
+
+    if (m_indirect_supported) {
+        gl(GenBuffers, (1, &m_indirect_buffer));
+    }
+}
+
+IndirectDrawBuilder::~IndirectDrawBuilder()
+{
+    if (m_indirect_buffer != 0) {
+        gl(DeleteBuffers, (1, &m_indirect_buffer));
+    }
+
+    if (m_draw_id_buffer != 0) {
+        gl(DeleteBuffers, (1, &m_draw_id_buffer));
+    }
+
+    track_gpu_free(GpuResourceType::INDIRECT_BUFFER, "", m_indirect_capacity + m_draw_id_capacity * sizeof(float));
+}
+
+void IndirectDrawBuilder::reserve_draw_ids(std::size_t count)
+{
+    if (count <= m_draw_id_capacity)
+        return;
+
+    std::size_t capacity = std::max<std::size_t>(count, m_draw_id_capacity * 2);
+
+    std::vector<float> draw_ids(capacity);
+    for (std::size_t i = 0; i < capacity; ++i) {
+        draw_ids[i] = i;
+    }
+
+    // Callers may be in the middle of filling their own vertex buffer
+    GLint array_buffer;
+    gl(GetIntegerv, (GL_ARRAY_BUFFER_BINDING, &array_buffer));
+    gl(BindBuffer, (GL_ARRAY_BUFFER, m_draw_id_buffer));
+    gl(BufferData, (GL_ARRAY_BUFFER, capacity * sizeof(float), draw_ids.data(), GL_STATIC_DRAW));
+    gl(BindBuffer, (GL_ARRAY_BUFFER, array_buffer));
+
+    track_gpu_reallocation(GpuResourceType::INDIRECT_BUFFER, "", m_draw_id_capacity * sizeof(float), capacity * sizeof(float));
+    m_draw_id_capacity = capacity;
+
+    frame_stats().buffer_reallocations += 1;
+    frame_stats().buffer_bytes_uploaded += capacity * sizeof(float);
+}
+
+void IndirectDrawBuilder::enable_draw_id(GLuint location)
+{
+    m_draw_id_location = location;
+
+    if (!m_indirect_supported) {
+        // Set per draw as a constant attribute value by `submit()`
+        gl(DisableVertexAttribArray, (location));
+        return;
+    }
+
+    if (m_draw_id_buffer == 0) {
+        gl(GenBuffers, (1, &m_draw_id_buffer));
+    }
+    reserve_draw_ids(1);
+
+    GLint array_buffer;
+    gl(GetIntegerv, (GL_ARRAY_BUFFER_BINDING, &array_buffer));
+    gl(BindBuffer, (GL_ARRAY_BUFFER, m_draw_id_buffer));
+    gl(EnableVertexAttribArray, (location));
+    gl(VertexAttribPointer, (location, 1, GL_FLOAT, GL_FALSE, sizeof(float), nullptr));
+    gl(VertexAttribDivisor, (location, 1));
+    gl(BindBuffer, (GL_ARRAY_BUFFER, array_buffer));
+}
+
+void IndirectDrawBuilder::add(GLuint first_index, GLuint index_count, GLint base_vertex)
+{
+    m_commands.push_back({
+        .count = index_count,
+        .instance_count = 1,
+        .first_index = first_index,
+        .base_vertex = base_vertex,
+        .base_instance = static_cast<GLuint>(m_commands.size()),
+    });
+}
+
+void IndirectDrawBuilder::submit(GLenum mode)
+{
+    trace_scope("IndirectDrawBuilder::submit");
+
+    if (m_commands.empty())
+        return;
+
+    std::size_t commands_size = m_commands.size() * sizeof(DrawElementsIndirectCommand);
+
+    for (const DrawElementsIndirectCommand& command : m_commands)
+        frame_stats().indices_drawn += command.count;
+
+    if (m_indirect_supported) {
+        if (m_draw_id_location != -1)
+            reserve_draw_ids(m_commands.size());
+
+        gl(BindBuffer, (GL_DRAW_INDIRECT_BUFFER, m_indirect_buffer));
+
+        // Orphans the previous commands instead of waiting on draws that
+        // may still read them
+        if (commands_size > m_indirect_capacity) {
+            track_gpu_reallocation(GpuResourceType::INDIRECT_BUFFER, "", m_indirect_capacity, commands_size);
+            m_indirect_capacity = commands_size;
+        }
+        gl(BufferData, (GL_DRAW_INDIRECT_BUFFER, m_indirect_capacity, nullptr, GL_STREAM_DRAW));
+        gl(BufferSubData, (GL_DRAW_INDIRECT_BUFFER, 0, commands_size, m_commands.data()));
+
+        gl(MultiDrawElementsIndirect, (mode, GL_UNSIGNED_INT, nullptr, m_commands.size(), 0));
+
+        gl(BindBuffer, (GL_DRAW_INDIRECT_BUFFER, 0));
+
+        frame_stats().draw_calls += 1;
+        frame_stats().buffer_bytes_uploaded += commands_size;
+        return;
+    }
+
+    if (m_draw_id_location != -1) {
+        // Without base instances the draw id can only change between calls
+        for (std::size_t i = 0; i < m_commands.size(); ++i) {
+            const DrawElementsIndirectCommand& command = m_commands[i];
+
+            gl(VertexAttrib1f, (m_draw_id_location, static_cast<float>(i)));
+            gl(DrawElementsBaseVertex, (mode, command.count, GL_UNSIGNED_INT,
+                                        reinterpret_cast<const void*>(command.first_index * sizeof(GLuint)),
+                                        command.base_vertex));
+        }
+
+        frame_stats().draw_calls += m_commands.size();
+        return;
+    }
+
+    m_counts.clear();
+    m_offsets.clear();
+    m_base_vertices.clear();
+    for (const DrawElementsIndirectCommand& command : m_commands) {
+        m_counts.push_back(command.count);
+        m_offsets.push_back(reinterpret_cast<const void*>(command.first_index * sizeof(GLuint)));
+        m_base_vertices.push_back(command.base_vertex);
+    }
+
+    gl(MultiDrawElementsBaseVertex, (mode, m_counts.data(), GL_UNSIGNED_INT,
+                                     m_offsets.data(), m_commands.size(),
+                                     m_base_vertices.data()));
+
+    frame_stats().draw_calls += 1;
+}
+
+void IndirectDrawBuilder::clear()
+{
+    m_commands.clear();
+}
+
+}
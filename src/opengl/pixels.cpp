@@ -0,0 +1,519 @@
+#include "opengl/pixels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXELS_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define PIXELS_NEON
+#include <arm_neon.h>
+#endif
+
+struct SrgbTables {
+    float to_linear[256];
+    // Indexed by a linear value scaled to [0, 4095]. Stored as 32-bit
+    // integers so the AVX2 kernel can gather from it.
+    std::uint32_t to_srgb[4096];
+};
+
+static const SrgbTables& srgb_tables()
+{
+    static const SrgbTables tables = [] {
+        SrgbTables tables;
+
+        for (int i = 0; i < 256; ++i) {
+            double c = i / 255.0;
+            tables.to_linear[i] = c <= 0.04045
+                ? c / 12.92
+                : std::pow((c + 0.055) / 1.055, 2.4);
+        }
+
+        for (int i = 0; i < 4096; ++i) {
+            double v = i / 4095.0;
+            double s = v <= 0.0031308
+                ? v * 12.92
+                : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055;
+            tables.to_srgb[i] = std::lround(s * 255.0);
+        }
+
+        return tables;
+    }();
+
+    return tables;
+}
+
+// Rounded x * a / 255, exact for every 8-bit input
+static inline unsigned char multiply_div_255(unsigned int x, unsigned int a)
+{
+    unsigned int t = x * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static inline unsigned char linear_to_srgb_byte(float value)
+{
+    value = std::clamp(value, 0.0f, 1.0f);
+    return srgb_tables().to_srgb[static_cast<int>(value * 4095.0f + 0.5f)];
+}
+
+static inline unsigned char linear_to_byte(float value)
+{
+    value = std::clamp(value, 0.0f, 1.0f);
+    return static_cast<unsigned char>(value * 255.0f + 0.5f);
+}
+
+/*                        *
+ *   Scalar fallbacks     *
+ *                        */
+
+static void expand_rgb_to_rgba_scalar(const unsigned char* src, unsigned char* dst,
+                                      std::size_t pixel_count)
+{
+    for (std::size_t i = 0; i < pixel_count; ++i) {
+        dst[i * 4 + 0] = src[i * 3 + 0];
+        dst[i * 4 + 1] = src[i * 3 + 1];
+        dst[i * 4 + 2] = src[i * 3 + 2];
+        dst[i * 4 + 3] = 0xFF;
+    }
+}
+
+static void premultiply_alpha_scalar(unsigned char* pixels, std::size_t pixel_count)
+{
+    for (std::size_t i = 0; i < pixel_count; ++i) {
+        unsigned char* pixel = pixels + i * 4;
+        pixel[0] = multiply_div_255(pixel[0], pixel[3]);
+        pixel[1] = multiply_div_255(pixel[1], pixel[3]);
+        pixel[2] = multiply_div_255(pixel[2], pixel[3]);
+    }
+}
+
+static void swizzle_rgba_to_bgra_scalar(unsigned char* pixels, std::size_t pixel_count)
+{
+    for (std::size_t i = 0; i < pixel_count; ++i) {
+        std::swap(pixels[i * 4 + 0], pixels[i * 4 + 2]);
+    }
+}
+
+static void srgb_to_linear_scalar(const unsigned char* src, float* dst,
+                                  std::size_t pixel_count)
+{
+    const float* to_linear = srgb_tables().to_linear;
+
+    for (std::size_t i = 0; i < pixel_count; ++i) {
+        dst[i * 4 + 0] = to_linear[src[i * 4 + 0]];
+        dst[i * 4 + 1] = to_linear[src[i * 4 + 1]];
+        dst[i * 4 + 2] = to_linear[src[i * 4 + 2]];
+        dst[i * 4 + 3] = src[i * 4 + 3] / 255.0f;
+    }
+}
+
+static void linear_to_srgb_scalar(const float* src, unsigned char* dst,
+                                  std::size_t pixel_count)
+{
+    for (std::size_t i = 0; i < pixel_count; ++i) {
+        dst[i * 4 + 0] = linear_to_srgb_byte(src[i * 4 + 0]);
+        dst[i * 4 + 1] = linear_to_srgb_byte(src[i * 4 + 1]);
+        dst[i * 4 + 2] = linear_to_srgb_byte(src[i * 4 + 2]);
+        dst[i * 4 + 3] = linear_to_byte(src[i * 4 + 3]);
+    }
+}
+
+#if defined(PIXELS_X86)
+
+/*                        *
+ *   SSE2 / SSSE3         *
+ *                        */
+
+__attribute__((target("sse2"))) static inline __m128i
+premultiply_lanes_sse2(__m128i x)
+{
+    // 16-bit lanes 3 and 7 hold alpha, which gets multiplied by 255 so that
+    // it comes out unchanged
+    const __m128i color_lanes = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alpha_one = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i bias = _mm_set1_epi16(128);
+
+    __m128i a = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_or_si128(_mm_and_si128(a, color_lanes), alpha_one);
+
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, a), bias);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("sse2"))) static void
+premultiply_alpha_sse2(unsigned char* pixels, std::size_t pixel_count)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    std::size_t i = 0;
+    for (; i + 4 <= pixel_count; i += 4) {
+        __m128i* p = reinterpret_cast<__m128i*>(pixels + i * 4);
+        __m128i v = _mm_loadu_si128(p);
+
+        __m128i lo = premultiply_lanes_sse2(_mm_unpacklo_epi8(v, zero));
+        __m128i hi = premultiply_lanes_sse2(_mm_unpackhi_epi8(v, zero));
+
+        _mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+    }
+
+    premultiply_alpha_scalar(pixels + i * 4, pixel_count - i);
+}
+
+__attribute__((target("sse2"))) static void
+swizzle_rgba_to_bgra_sse2(unsigned char* pixels, std::size_t pixel_count)
+{
+    const __m128i green_alpha = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+
+    std::size_t i = 0;
+    for (; i + 4 <= pixel_count; i += 4) {
+        __m128i* p = reinterpret_cast<__m128i*>(pixels + i * 4);
+        __m128i v = _mm_loadu_si128(p);
+
+        // Shifting each 32-bit pixel by 16 both ways moves red to byte 2 and
+        // blue to byte 0, pushing everything else out of the lane
+        __m128i red_blue = _mm_andnot_si128(green_alpha, v);
+        red_blue = _mm_or_si128(_mm_slli_epi32(red_blue, 16), _mm_srli_epi32(red_blue, 16));
+
+        _mm_storeu_si128(p, _mm_or_si128(_mm_and_si128(v, green_alpha), red_blue));
+    }
+
+    swizzle_rgba_to_bgra_scalar(pixels + i * 4, pixel_count - i);
+}
+
+__attribute__((target("ssse3"))) static void
+expand_rgb_to_rgba_ssse3(const unsigned char* src, unsigned char* dst,
+                         std::size_t pixel_count)
+{
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,
+                                          6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+    // Each iteration loads 16 bytes but only consumes 12 of them, so stop
+    // while the load still stays inside `src`
+    std::size_t i = 0;
+    for (; i + 6 <= pixel_count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+        v = _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), v);
+    }
+
+    expand_rgb_to_rgba_scalar(src + i * 3, dst + i * 4, pixel_count - i);
+}
+
+/*                        *
+ *   AVX2                 *
+ *                        */
+
+__attribute__((target("avx2"))) static inline __m256i
+premultiply_lanes_avx2(__m256i x)
+{
+    const __m256i color_lanes = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1,
+                                                 0, -1, -1, -1, 0, -1, -1, -1);
+    const __m256i alpha_one = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0,
+                                               255, 0, 0, 0, 255, 0, 0, 0);
+    const __m256i bias = _mm256_set1_epi16(128);
+
+    __m256i a = _mm256_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm256_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm256_or_si256(_mm256_and_si256(a, color_lanes), alpha_one);
+
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, a), bias);
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("avx2"))) static void
+premultiply_alpha_avx2(unsigned char* pixels, std::size_t pixel_count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    // Unpacking and packing both work per 128-bit lane, so pixel order is
+    // preserved without any cross-lane permute
+    std::size_t i = 0;
+    for (; i + 8 <= pixel_count; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(pixels + i * 4);
+        __m256i v = _mm256_loadu_si256(p);
+
+        __m256i lo = premultiply_lanes_avx2(_mm256_unpacklo_epi8(v, zero));
+        __m256i hi = premultiply_lanes_avx2(_mm256_unpackhi_epi8(v, zero));
+
+        _mm256_storeu_si256(p, _mm256_packus_epi16(lo, hi));
+    }
+
+    premultiply_alpha_sse2(pixels + i * 4, pixel_count - i);
+}
+
+__attribute__((target("avx2"))) static void
+swizzle_rgba_to_bgra_avx2(unsigned char* pixels, std::size_t pixel_count)
+{
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7,
+                                             10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7,
+                                             10, 9, 8, 11, 14, 13, 12, 15);
+
+    std::size_t i = 0;
+    for (; i + 8 <= pixel_count; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(pixels + i * 4);
+        _mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), shuffle));
+    }
+
+    swizzle_rgba_to_bgra_sse2(pixels + i * 4, pixel_count - i);
+}
+
+__attribute__((target("avx2"))) static void
+expand_rgb_to_rgba_avx2(const unsigned char* src, unsigned char* dst,
+                        std::size_t pixel_count)
+{
+    const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,
+                                             6, 7, 8, -1, 9, 10, 11, -1,
+                                             0, 1, 2, -1, 3, 4, 5, -1,
+                                             6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+    // Two overlapping 16 byte loads, 12 bytes apart, feed the two lanes.
+    // The second one reads 4 bytes past the 8 pixels being converted.
+    std::size_t i = 0;
+    for (; i + 10 <= pixel_count; i += 8) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3 + 12));
+
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), v);
+    }
+
+    expand_rgb_to_rgba_ssse3(src + i * 3, dst + i * 4, pixel_count - i);
+}
+
+__attribute__((target("avx2"))) static void
+srgb_to_linear_avx2(const unsigned char* src, float* dst, std::size_t pixel_count)
+{
+    const float* to_linear = srgb_tables().to_linear;
+    const __m256 alpha_scale = _mm256_set1_ps(1.0f / 255.0f);
+
+    std::size_t i = 0;
+    for (; i + 2 <= pixel_count; i += 2) {
+        __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * 4));
+        __m256i indices = _mm256_cvtepu8_epi32(bytes);
+
+        __m256 color = _mm256_i32gather_ps(to_linear, indices, 4);
+        __m256 alpha = _mm256_mul_ps(_mm256_cvtepi32_ps(indices), alpha_scale);
+
+        // Lanes 3 and 7 are the alpha of the two pixels
+        _mm256_storeu_ps(dst + i * 4, _mm256_blend_ps(color, alpha, 0x88));
+    }
+
+    srgb_to_linear_scalar(src + i * 4, dst + i * 4, pixel_count - i);
+}
+
+__attribute__((target("avx2"))) static void
+linear_to_srgb_avx2(const float* src, unsigned char* dst, std::size_t pixel_count)
+{
+    const int* to_srgb = reinterpret_cast<const int*>(srgb_tables().to_srgb);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    std::size_t i = 0;
+    for (; i + 2 <= pixel_count; i += 2) {
+        __m256 v = _mm256_loadu_ps(src + i * 4);
+        v = _mm256_min_ps(_mm256_max_ps(v, zero), one);
+
+        __m256i indices = _mm256_cvttps_epi32(
+            _mm256_add_ps(_mm256_mul_ps(v, _mm256_set1_ps(4095.0f)), half));
+        __m256i color = _mm256_i32gather_epi32(to_srgb, indices, 4);
+        __m256i alpha = _mm256_cvttps_epi32(
+            _mm256_add_ps(_mm256_mul_ps(v, _mm256_set1_ps(255.0f)), half));
+
+        __m256i result = _mm256_blend_epi32(color, alpha, 0x88);
+
+        __m128i words = _mm_packus_epi32(_mm256_castsi256_si128(result),
+                                         _mm256_extracti128_si256(result, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * 4),
+                         _mm_packus_epi16(words, words));
+    }
+
+    linear_to_srgb_scalar(src + i * 4, dst + i * 4, pixel_count - i);
+}
+
+#elif defined(PIXELS_NEON)
+
+/*                        *
+ *   NEON                 *
+ *                        */
+
+static void expand_rgb_to_rgba_neon(const unsigned char* src, unsigned char* dst,
+                                    std::size_t pixel_count)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= pixel_count; i += 16) {
+        uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+
+        uint8x16x4_t rgba;
+        rgba.val[0] = rgb.val[0];
+        rgba.val[1] = rgb.val[1];
+        rgba.val[2] = rgb.val[2];
+        rgba.val[3] = vdupq_n_u8(0xFF);
+
+        vst4q_u8(dst + i * 4, rgba);
+    }
+
+    expand_rgb_to_rgba_scalar(src + i * 3, dst + i * 4, pixel_count - i);
+}
+
+static inline uint8x16_t multiply_div_255_neon(uint8x16_t x, uint8x16_t a)
+{
+    // vraddhn(t, vrshr(t, 8)) is the same rounded division by 255 as
+    // `multiply_div_255()`
+    uint16x8_t lo = vmull_u8(vget_low_u8(x), vget_low_u8(a));
+    uint16x8_t hi = vmull_u8(vget_high_u8(x), vget_high_u8(a));
+
+    return vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)),
+                       vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+}
+
+static void premultiply_alpha_neon(unsigned char* pixels, std::size_t pixel_count)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= pixel_count; i += 16) {
+        uint8x16x4_t rgba = vld4q_u8(pixels + i * 4);
+
+        rgba.val[0] = multiply_div_255_neon(rgba.val[0], rgba.val[3]);
+        rgba.val[1] = multiply_div_255_neon(rgba.val[1], rgba.val[3]);
+        rgba.val[2] = multiply_div_255_neon(rgba.val[2], rgba.val[3]);
+
+        vst4q_u8(pixels + i * 4, rgba);
+    }
+
+    premultiply_alpha_scalar(pixels + i * 4, pixel_count - i);
+}
+
+static void swizzle_rgba_to_bgra_neon(unsigned char* pixels, std::size_t pixel_count)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= pixel_count; i += 16) {
+        uint8x16x4_t rgba = vld4q_u8(pixels + i * 4);
+        std::swap(rgba.val[0], rgba.val[2]);
+        vst4q_u8(pixels + i * 4, rgba);
+    }
+
+    swizzle_rgba_to_bgra_scalar(pixels + i * 4, pixel_count - i);
+}
+
+#endif
+
+struct PixelKernels {
+    const char* name;
+    void (*expand_rgb_to_rgba)(const unsigned char*, unsigned char*, std::size_t);
+    void (*premultiply_alpha)(unsigned char*, std::size_t);
+    void (*swizzle_rgba_to_bgra)(unsigned char*, std::size_t);
+    void (*srgb_to_linear)(const unsigned char*, float*, std::size_t);
+    void (*linear_to_srgb)(const float*, unsigned char*, std::size_t);
+};
+
+static PixelKernels select_kernels()
+{
+    PixelKernels kernels = {
+        .name = "scalar",
+        .expand_rgb_to_rgba = expand_rgb_to_rgba_scalar,
+        .premultiply_alpha = premultiply_alpha_scalar,
+        .swizzle_rgba_to_bgra = swizzle_rgba_to_bgra_scalar,
+        .srgb_to_linear = srgb_to_linear_scalar,
+        .linear_to_srgb = linear_to_srgb_scalar,
+    };
+
+#if defined(PIXELS_X86)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("sse2")) {
+        kernels.name = "sse2";
+        kernels.premultiply_alpha = premultiply_alpha_sse2;
+        kernels.swizzle_rgba_to_bgra = swizzle_rgba_to_bgra_sse2;
+    }
+
+    if (__builtin_cpu_supports("ssse3")) {
+        kernels.name = "ssse3";
+        kernels.expand_rgb_to_rgba = expand_rgb_to_rgba_ssse3;
+    }
+
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.name = "avx2";
+        kernels.expand_rgb_to_rgba = expand_rgb_to_rgba_avx2;
+        kernels.premultiply_alpha = premultiply_alpha_avx2;
+        kernels.swizzle_rgba_to_bgra = swizzle_rgba_to_bgra_avx2;
+        kernels.srgb_to_linear = srgb_to_linear_avx2;
+        kernels.linear_to_srgb = linear_to_srgb_avx2;
+    }
+#elif defined(PIXELS_NEON)
+    kernels.name = "neon";
+    kernels.expand_rgb_to_rgba = expand_rgb_to_rgba_neon;
+    kernels.premultiply_alpha = premultiply_alpha_neon;
+    kernels.swizzle_rgba_to_bgra = swizzle_rgba_to_bgra_neon;
+#endif
+
+    return kernels;
+}
+
+static const PixelKernels& kernels()
+{
+    static const PixelKernels selected = select_kernels();
+    return selected;
+}
+
+namespace GL {
+
+void expand_rgb_to_rgba(const unsigned char* src, unsigned char* dst,
+                        std::size_t pixel_count)
+{
+    kernels().expand_rgb_to_rgba(src, dst, pixel_count);
+}
+
+void premultiply_alpha(unsigned char* pixels, std::size_t pixel_count)
+{
+    kernels().premultiply_alpha(pixels, pixel_count);
+}
+
+void swizzle_rgba_to_bgra(unsigned char* pixels, std::size_t pixel_count)
+{
+    kernels().swizzle_rgba_to_bgra(pixels, pixel_count);
+}
+
+void srgb_to_linear(const unsigned char* src, float* dst, std::size_t pixel_count)
+{
+    kernels().srgb_to_linear(src, dst, pixel_count);
+}
+
+void linear_to_srgb(const float* src, unsigned char* dst, std::size_t pixel_count)
+{
+    kernels().linear_to_srgb(src, dst, pixel_count);
+}
+
+void flip_rows(unsigned char* pixels, std::size_t row_size, std::size_t row_count)
+{
+    if (row_count < 2)
+        return;
+
+    // Row swaps are plain memcpy, which libc already vectorizes
+    std::vector<unsigned char> scratch(row_size);
+
+    for (std::size_t top = 0, bottom = row_count - 1; top < bottom; ++top, --bottom) {
+        unsigned char* top_row = pixels + top * row_size;
+        unsigned char* bottom_row = pixels + bottom * row_size;
+
+        std::memcpy(scratch.data(), top_row, row_size);
+        std::memcpy(top_row, bottom_row, row_size);
+        std::memcpy(bottom_row, scratch.data(), row_size);
+    }
+}
+
+const char* pixel_kernels_name()
+{
+    return kernels().name;
+}
+
+}
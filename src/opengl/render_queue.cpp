@@ -0,0 +1,175 @@
+#include "opengl/render_queue.hpp"
+
+#include <algorithm>
+
+#include "opengl/frame_stats.hpp"
+#include "opengl/gl_errors.hpp"
+#include "opengl/trace.hpp"
+
+#define LAYER_SHIFT 56
+#define TRANSLUCENT_SHIFT 55
+#define SHADER_SHIFT 43
+#define TEXTURE_SHIFT 27
+#define VERTEX_ARRAY_SHIFT 19
+#define INDEX_BUFFER_SHIFT 11
+#define DEPTH_SHIFT 0
+
+#define SHADER_MASK 0xFFFull
+#define TEXTURE_MASK 0xFFFFull
+#define VERTEX_ARRAY_MASK 0xFFull
+#define INDEX_BUFFER_MASK 0xFFull
+#define DEPTH_MASK 0x7FFull
+#define SEQUENCE_MASK ((1ull << TRANSLUCENT_SHIFT) - 1)
+
+// Stable LSD radix sort of `order` by `keys`, one byte per pass. Passes in
+// which every key has the same byte are skipped, which is most of them
+// when only a few layers and shaders are in use.
+static void radix_sort(const std::vector<std::uint64_t>& keys,
+                       std::vector<std::uint32_t>& order,
+                       std::vector<std::uint32_t>& scratch)
+{
+    std::size_t count = keys.size();
+    scratch.resize(count);
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        std::size_t histogram[256] = { 0 };
+        for (std::uint32_t index : order) {
+            histogram[(keys[index] >> shift) & 0xFF] += 1;
+        }
+
+        if (histogram[(keys[order[0]] >> shift) & 0xFF] == count)
+            continue;
+
+        std::size_t offset = 0;
+        for (std::size_t& bucket : histogram) {
+            std::size_t bucket_count = bucket;
+            bucket = offset;
+            offset += bucket_count;
+        }
+
+        for (std::uint32_t index : order) {
+            scratch[histogram[(keys[index] >> shift) & 0xFF]++] = index;
+        }
+
+        order.swap(scratch);
+    }
+}
+
+namespace GL {
+
+std::uint64_t RenderQueue::sort_key(const RenderItem& item, std::uint64_t sequence)
+{
+    std::uint64_t key = std::uint64_t(item.layer & 0xFF) << LAYER_SHIFT;
+
+    if (item.translucent) {
+        return key
+            | 1ull << TRANSLUCENT_SHIFT
+            | (sequence & SEQUENCE_MASK);
+    }
+
+    float depth = std::clamp(item.depth, 0.0f, 1.0f);
+
+    // GL names are small integers, so masking them rarely merges two
+    // objects, and when it does only the grouping suffers
+    return key
+        | (item.shader->id() & SHADER_MASK) << SHADER_SHIFT
+        | (item.texture->id() & TEXTURE_MASK) << TEXTURE_SHIFT
+        | (item.vertex_array->id() & VERTEX_ARRAY_MASK) << VERTEX_ARRAY_SHIFT
+        | (item.index_buffer->id() & INDEX_BUFFER_MASK) << INDEX_BUFFER_SHIFT
+        | std::uint64_t(depth * DEPTH_MASK) << DEPTH_SHIFT;
+}
+
+void RenderQueue::push(const RenderItem& item)
+{
+    m_keys.push_back(sort_key(item, m_items.size()));
+    m_items.push_back(item);
+}
+
+void RenderQueue::submit()
+{
+    trace_scope("RenderQueue::submit");
+
+    m_stats = RenderQueueStats();
+    m_stats.items = m_items.size();
+
+    if (m_items.empty())
+        return;
+
+    m_order.resize(m_items.size());
+    for (std::uint32_t i = 0; i < m_order.size(); ++i) {
+        m_order[i] = i;
+    }
+
+    radix_sort(m_keys, m_order, m_scratch);
+
+    const Shader* shader = nullptr;
+    const Texture* texture = nullptr;
+    const VertexArray* vertex_array = nullptr;
+    const IndexBuffer* index_buffer = nullptr;
+    GLenum mode = GL_TRIANGLES;
+    int blending = -1;
+
+    auto flush = [&](FlushReason reason) {
+        if (m_draws.command_count() == 0)
+            return;
+
+        m_draws.submit(mode);
+        m_draws.clear();
+        m_stats.draw_calls += 1;
+        frame_stats().flushes[static_cast<std::size_t>(reason)] += 1;
+    };
+
+    for (std::uint32_t index : m_order) {
+        const RenderItem& item = m_items[index];
+
+        if (item.translucent != blending) {
+            flush(FlushReason::BLEND);
+
+            if (item.translucent) {
+                gl(Enable, (GL_BLEND));
+            } else {
+                gl(Disable, (GL_BLEND));
+            }
+
+            blending = item.translucent;
+            m_stats.blend_changes += 1;
+        }
+
+        if (item.shader != shader) {
+            flush(FlushReason::SHADER);
+            item.shader->bind();
+            shader = item.shader;
+            m_stats.shader_binds += 1;
+        }
+
+        if (item.texture != texture) {
+            flush(FlushReason::TEXTURE);
+            item.texture->bind(0);
+            texture = item.texture;
+            m_stats.texture_binds += 1;
+        }
+
+        if (item.vertex_array != vertex_array || item.index_buffer != index_buffer
+            || item.mode != mode) {
+            flush(FlushReason::GEOMETRY);
+
+            if (item.vertex_array != vertex_array) {
+                item.vertex_array->bind();
+                m_stats.vertex_array_binds += 1;
+            }
+
+            vertex_array = item.vertex_array;
+            index_buffer = item.index_buffer;
+            mode = item.mode;
+        }
+
+        m_draws.add(item.first_index, item.index_count, item.base_vertex);
+    }
+
+    flush(FlushReason::END);
+
+    m_items.clear();
+    m_keys.clear();
+}
+
+}
@@ -1,60 +1,221 @@
 #include "opengl/shader.hpp"
 
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <regex>
 #include <string>
+#include <vector>
 
+#include "opengl/frame_stats.hpp"
 #include "opengl/gl_errors.hpp"
-#include "opengl/shader.hpp"
-
-struct ShaderSources {
-    std::string vertex;
-    std::string fragment;
+#include "opengl/trace.hpp"
+
+struct ShaderStage {
+    GLenum type;
+    // Points into the shader file contents
+    std::string_view source;
+    // Line of the shader file the stage source starts at
+    std::size_t line;
 };
 
-static ShaderSources parse_shader(const std::string& path)
+static const char* shader_stage_name(GLenum type)
+{
+    switch (type) {
+
+    case GL_VERTEX_SHADER:
+        return "vertex";
+    case GL_FRAGMENT_SHADER:
+        return "fragment";
+    case GL_GEOMETRY_SHADER:
+        return "geometry";
+    case GL_COMPUTE_SHADER:
+        return "compute";
+
+    default:
+        return "unknown";
+    }
+}
+
+static bool shader_stage_type(std::string_view name, GLenum& type)
 {
-    std::ifstream stream(path);
+    for (GLenum candidate : { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER,
+                              GL_GEOMETRY_SHADER, GL_COMPUTE_SHADER }) {
+        if (name == shader_stage_name(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
 
-    std::string vertex_source;
-    std::string fragment_source;
-    GLenum shader_mode = GL_VERTEX_SHADER;
+    return false;
+}
 
-    std::string line;
-    while (getline(stream, line)) {
-        if (line.find("#shader") != std::string::npos) {
-            if (line.find("vertex") != std::string::npos)
-                shader_mode = GL_VERTEX_SHADER;
-            else if (line.find("fragment") != std::string::npos)
-                shader_mode = GL_FRAGMENT_SHADER;
+static bool is_blank(std::string_view text)
+{
+    return text.find_first_not_of(" \t\r\n") == std::string_view::npos;
+}
 
-            continue;
+// Splits a shader file into the stages introduced by `#shader <stage>`
+// lines, without copying any source. Text before the first of them is
+// ignored, and a file without any `#shader` line is a single vertex stage.
+static bool parse_shader(const std::string& name, std::string_view source,
+                         std::vector<ShaderStage>& stages)
+{
+    ShaderStage stage = { .type = GL_VERTEX_SHADER, .source = {}, .line = 1 };
+    std::size_t stage_start = 0;
+
+    std::size_t line_number = 1;
+    std::size_t line_start = 0;
+    while (line_start < source.size()) {
+        std::size_t line_end = source.find('\n', line_start);
+        if (line_end == std::string_view::npos)
+            line_end = source.size();
+
+        std::string_view line = source.substr(line_start, line_end - line_start);
+        std::size_t directive = line.find_first_not_of(" \t");
+
+        if (directive != std::string_view::npos && line.substr(directive).starts_with("#shader")) {
+            // Text before the first `#shader` line, a license or comment
+            // header for example, belongs to no stage
+            stage.source = source.substr(stage_start, line_start - stage_start);
+            if (stage_start != 0 && !is_blank(stage.source))
+                stages.push_back(stage);
+
+            std::string_view arguments = line.substr(directive + sizeof("#shader") - 1);
+            std::size_t stage_name_start = arguments.find_first_not_of(" \t");
+            std::size_t stage_name_end = arguments.find_first_of(" \t\r", stage_name_start);
+            std::string_view stage_name = stage_name_start == std::string_view::npos
+                ? std::string_view()
+                : arguments.substr(stage_name_start, stage_name_end - stage_name_start);
+
+            if (!shader_stage_type(stage_name, stage.type)) {
+                std::cerr << name << ":" << line_number
+                          << ": ERROR: unknown shader stage `" << stage_name << "`\n";
+                return false;
+            }
+
+            stage_start = line_end + 1;
+            stage.line = line_number + 1;
         }
 
-        if (shader_mode == GL_VERTEX_SHADER) {
-            vertex_source.append(line);
-            vertex_source.append("\n");
-        } else if (shader_mode == GL_FRAGMENT_SHADER) {
-            fragment_source.append(line);
-            fragment_source.append("\n");
+        line_start = line_end + 1;
+        line_number += 1;
+    }
+
+    if (stage_start < source.size()) {
+        stage.source = source.substr(stage_start);
+        if (!is_blank(stage.source))
+            stages.push_back(stage);
+    }
+
+    for (std::size_t i = 0; i < stages.size(); ++i) {
+        for (std::size_t j = 0; j < i; ++j) {
+            if (stages[i].type == stages[j].type) {
+                std::cerr << name << ":" << stages[i].line - 1 << ": ERROR: duplicate "
+                          << shader_stage_name(stages[i].type) << " stage\n";
+                return false;
+            }
         }
+
+        if (stages[i].type == GL_COMPUTE_SHADER && stages.size() > 1) {
+            std::cerr << name << ":" << stages[i].line - 1
+                      << ": ERROR: compute stages cannot be combined with other stages\n";
+            return false;
+        }
+    }
+
+    if (stages.empty()) {
+        std::cerr << name << ": ERROR: shader has no stages\n";
+        return false;
     }
 
-    return (ShaderSources) {
-        .vertex = vertex_source,
-        .fragment = fragment_source,
-    };
+    return true;
 }
 
-static GLuint compile_shader(GLenum type, const std::string& source)
+// Rewrites the `0:LINE` and `0(LINE)` locations used by compiler logs into
+// `name:LINE` locations in the shader file
+static std::string remap_log_lines(const std::string& name, const char* log,
+                                   std::size_t first_line)
 {
-    GLuint id;
-    gl_call(id = glCreateShader(type));
+    static const std::regex location(R"(\b0([:(])(\d+))");
 
-    const char* c_source = source.c_str();
-    gl(ShaderSource, (id, 1, &c_source, nullptr));
-    gl(CompileShader, (id));
+    std::string remapped;
+    std::cregex_iterator end;
+    const char* copied = log;
+
+    for (std::cregex_iterator it(log, log + std::strlen(log), location); it != end; ++it) {
+        const std::cmatch& match = *it;
+        std::size_t line = std::stoul(match[2].str()) + first_line - 1;
+
+        remapped.append(copied, match[0].first);
+        remapped.append(name);
+        remapped.append(match[1].str());
+        remapped.append(std::to_string(line));
+
+        copied = match[0].second;
+    }
 
+    remapped.append(copied);
+    return remapped;
+}
+
+namespace GL {
+
+// A program whose stages were handed to the driver. With
+// GL_KHR_parallel_shader_compile the driver compiles and links it on its
+// own threads, the results are only queried once it reports completion.
+// Without it the first query blocks until the driver is done, so a reload
+// stalls the frame it finishes in.
+struct PendingProgram {
+    GLuint program = 0;
+    std::vector<GLuint> shaders;
+    // The stage sources are not used once handed to the driver
+    std::vector<ShaderStage> stages;
+};
+
+}
+
+static bool start_program(const std::string& name, std::string_view source,
+                          GL::PendingProgram& pending)
+{
+    trace_scope("compile shader");
+
+    if (!parse_shader(name, source, pending.stages))
+        return false;
+
+    gl_call(pending.program = gl_fn(CreateProgram)());
+
+    for (const ShaderStage& stage : pending.stages) {
+        GLuint id;
+        gl_call(id = gl_fn(CreateShader)(stage.type));
+
+        const char* c_source = stage.source.data();
+        GLint length = stage.source.size();
+        gl(ShaderSource, (id, 1, &c_source, &length));
+        gl(CompileShader, (id));
+
+        gl(AttachShader, (pending.program, id));
+        pending.shaders.push_back(id);
+    }
+
+    gl(LinkProgram, (pending.program));
+
+    return true;
+}
+
+static bool is_program_ready(const GL::PendingProgram& pending)
+{
+    if (!GLEW_KHR_parallel_shader_compile)
+        return true;
+
+    int completed;
+    gl(GetProgramiv, (pending.program, GL_COMPLETION_STATUS_KHR, &completed));
+
+    return completed == GL_TRUE;
+}
+
+static bool check_compile_status(const std::string& name, const ShaderStage& stage, GLuint id)
+{
     int result;
     gl(GetShaderiv, (id, GL_COMPILE_STATUS, &result));
 
@@ -65,68 +226,188 @@ static GLuint compile_shader(GLenum type, const std::string& source)
         char* error = (char*)alloca(error_length);
         gl(GetShaderInfoLog, (id, error_length, &error_length, error));
 
-        const char* shader_type = type == GL_VERTEX_SHADER ? "vertex" : "fragment";
+        std::cerr << name << ":" << stage.line << ": ERROR: "
+                  << shader_stage_name(stage.type) << " shader compilation:\n"
+                  << remap_log_lines(name, error, stage.line);
+
+        return false;
+    }
+
+    return true;
+}
+
+// Reports the compile and link errors of a pending program, blocking if the
+// driver is not done with it. Returns the program, or 0 on failure.
+static GLuint finish_program(const std::string& name, GL::PendingProgram& pending)
+{
+    trace_scope("link shader");
+
+    bool compiled = true;
+    for (std::size_t i = 0; i < pending.shaders.size(); ++i) {
+        // Every stage is checked, so that the log of each failing one is written
+        bool stage_compiled = check_compile_status(name, pending.stages[i], pending.shaders[i]);
+        compiled = compiled && stage_compiled;
+
+        // Attached shaders are only flagged for deletion until the program goes
+        gl(DeleteShader, (pending.shaders[i]));
+    }
+
+    GLuint program = pending.program;
+    pending = GL::PendingProgram();
+
+    if (!compiled) {
+        gl(DeleteProgram, (program));
+        return 0;
+    }
+
+    int result;
+    gl(GetProgramiv, (program, GL_LINK_STATUS, &result));
+
+    if (result == GL_FALSE) {
+        int error_length;
+        gl(GetProgramiv, (program, GL_INFO_LOG_LENGTH, &error_length));
 
-        std::cerr << "ERROR: " << shader_type << " shader compilation: "
-                  << error;
+        char* error = (char*)alloca(error_length);
+        gl(GetProgramInfoLog, (program, error_length, &error_length, error));
 
-        gl(DeleteShader, (id));
+        std::cerr << name << ": ERROR: shader linking: " << error;
 
+        gl(DeleteProgram, (program));
         return 0;
     }
 
-    return id;
+    gl(ValidateProgram, (program));
+
+    return program;
+}
+
+// Compiles and links every stage of a shader file into a program, returns
+// 0 on failure
+static GLuint create_program(const std::string& name, std::string_view source)
+{
+    GL::PendingProgram pending;
+    if (!start_program(name, source, pending))
+        return 0;
+
+    return finish_program(name, pending);
+}
+
+// Bitwise, so that 0.0 and -0.0 tell apart and a NaN matches itself
+static bool is_same_value(const float* cached, const float* values, std::size_t count)
+{
+    return std::memcmp(cached, values, count * sizeof(float)) == 0;
+}
+
+static bool read_shader_file(const std::string& path, std::string& source)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) {
+        std::cerr << "ERROR: could not open shader `" << path << "`\n";
+        return false;
+    }
+
+    source.resize(stream.tellg());
+    stream.seekg(0);
+    stream.read(source.data(), source.size());
+
+    return bool(stream);
 }
 
 namespace GL {
 
-int Shader::get_uniform_location(const std::string& name)
+UniformState& Shader::get_uniform(std::string_view name)
 {
-    if (m_locations.find(name) != m_locations.end()) {
-        return m_locations.at(name);
+    auto uniform = m_uniforms.find(name);
+    if (uniform != m_uniforms.end()) {
+        return uniform->second;
     }
 
+    // Only the first lookup of a name copies it
+    std::string key(name);
     int location;
-    gl_call(location = glGetUniformLocation(m_id, name.c_str()));
+    gl_call(location = gl_fn(GetUniformLocation)(m_id, key.c_str()));
 
-    m_locations[name] = location;
-
-    return location;
+    return m_uniforms[std::move(key)] = { .location = location, .type = GL_NONE, .values = {}, .integer = 0 };
 }
 
 Shader::Shader(const std::string& path)
+    : m_name(path)
 {
-    ShaderSources shader_sources = parse_shader(path);
-
-    gl_call(m_id = glCreateProgram());
-
-    GLuint vert_shader = compile_shader(GL_VERTEX_SHADER,
-                                        shader_sources.vertex);
-    if (vert_shader == 0) {
-        gl(DeleteProgram, (m_id));
+    std::string source;
+    if (!read_shader_file(path, source)) {
+        m_id = 0;
         m_valid = false;
+        return;
     }
 
-    GLuint frag_shader = compile_shader(GL_FRAGMENT_SHADER,
-                                        shader_sources.fragment);
-    if (frag_shader == 0) {
-        gl(DeleteProgram, (m_id));
-        m_valid = false;
-    }
+    m_id = create_program(m_name, source);
+    m_valid = m_id != 0;
+}
 
-    gl(AttachShader, (m_id, vert_shader));
-    gl(AttachShader, (m_id, frag_shader));
+Shader::Shader(const std::string& name, std::string_view source)
+    : m_name(name)
+{
+    m_id = create_program(m_name, source);
+    m_valid = m_id != 0;
+}
 
-    gl(LinkProgram, (m_id));
-    gl(ValidateProgram, (m_id));
+Shader::~Shader()
+{
+    cancel_reload();
+    gl(DeleteProgram, (m_id));
+}
+
+void Shader::reload(std::string_view source)
+{
+    cancel_reload();
+
+    m_pending = new PendingProgram();
+    if (!start_program(m_name, source, *m_pending))
+        cancel_reload();
+}
+
+bool Shader::finish_reload()
+{
+    if (m_pending == nullptr || !is_program_ready(*m_pending))
+        return false;
+
+    GLuint program = finish_program(m_name, *m_pending);
+    delete m_pending;
+    m_pending = nullptr;
+
+    // A broken reload keeps the current program
+    if (program == 0)
+        return false;
+
+    gl(DeleteProgram, (m_id));
+    m_id = program;
+    m_valid = true;
+    m_uniforms.clear();
+
+    std::cout << "[INFO] Reloaded shader `" << m_name << "`\n";
+
+    return true;
+}
+
+void Shader::cancel_reload()
+{
+    if (m_pending == nullptr)
+        return;
 
-    gl(DeleteShader, (vert_shader));
-    gl(DeleteShader, (frag_shader));
+    for (GLuint shader : m_pending->shaders) {
+        gl(DeleteShader, (shader));
+    }
+    gl(DeleteProgram, (m_pending->program));
+
+    delete m_pending;
+    m_pending = nullptr;
 }
 
 void Shader::bind() const
 {
     gl(UseProgram, (m_id));
+
+    frame_stats().program_binds += 1;
 }
 
 void Shader::unbind() const
@@ -134,24 +415,56 @@ void Shader::unbind() const
     gl(UseProgram, (0));
 }
 
-void Shader::set_uniform(const std::string& name,
+void Shader::set_uniform(std::string_view name,
                          float x, float y, float z, float w)
 {
-    int location = get_uniform_location(name);
-    gl(Uniform4f, (location, x, y, z, w));
+    UniformState& uniform = get_uniform(name);
+    float values[4] = { x, y, z, w };
+
+    if (uniform.type == GL_FLOAT_VEC4 && is_same_value(uniform.values, values, 4)) {
+        frame_stats().uniform_uploads_skipped += 1;
+        return;
+    }
+
+    gl(Uniform4f, (uniform.location, x, y, z, w));
+
+    uniform.type = GL_FLOAT_VEC4;
+    std::memcpy(uniform.values, values, sizeof(values));
+    frame_stats().uniform_uploads += 1;
 }
 
-void Shader::set_uniform(const std::string& name,
+void Shader::set_uniform(std::string_view name,
                          float x, float y, float z)
 {
-    int location = get_uniform_location(name);
-    gl(Uniform3f, (location, x, y, z));
+    UniformState& uniform = get_uniform(name);
+    float values[3] = { x, y, z };
+
+    if (uniform.type == GL_FLOAT_VEC3 && is_same_value(uniform.values, values, 3)) {
+        frame_stats().uniform_uploads_skipped += 1;
+        return;
+    }
+
+    gl(Uniform3f, (uniform.location, x, y, z));
+
+    uniform.type = GL_FLOAT_VEC3;
+    std::memcpy(uniform.values, values, sizeof(values));
+    frame_stats().uniform_uploads += 1;
 }
 
-void Shader::set_uniform(const std::string& name, int x)
+void Shader::set_uniform(std::string_view name, int x)
 {
-    int location = get_uniform_location(name);
-    gl(Uniform1i, (location, x));
+    UniformState& uniform = get_uniform(name);
+
+    if (uniform.type == GL_INT && uniform.integer == x) {
+        frame_stats().uniform_uploads_skipped += 1;
+        return;
+    }
+
+    gl(Uniform1i, (uniform.location, x));
+
+    uniform.type = GL_INT;
+    uniform.integer = x;
+    frame_stats().uniform_uploads += 1;
 }
 
 }
@@ -0,0 +1,237 @@
+#include "opengl/shader_watcher.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "opengl/gl_errors.hpp"
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+static bool read_source(const std::string& path, std::string& source)
+{
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+        return false;
+
+    source.resize(stream.tellg());
+    stream.seekg(0);
+    stream.read(source.data(), source.size());
+
+    return bool(stream);
+}
+
+namespace GL {
+
+ShaderWatcher::ShaderWatcher()
+{
+    if (GLEW_KHR_parallel_shader_compile) {
+        // Let the driver pick its number of compiler threads
+        gl(MaxShaderCompilerThreadsKHR, (0xFFFFFFFF));
+    }
+
+    m_inotify = inotify_init1(IN_CLOEXEC);
+    if (m_inotify == -1 || pipe2(m_wake, O_CLOEXEC) == -1) {
+        std::cerr << "ERROR: shader watcher: could not initialize inotify\n";
+
+        if (m_inotify != -1)
+            close(m_inotify);
+        m_inotify = -1;
+        return;
+    }
+
+    m_thread = std::thread(&ShaderWatcher::watch_loop, this);
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+    if (!is_valid())
+        return;
+
+    // Closing the only write end of the pipe wakes the thread's poll() with
+    // POLLHUP, which cannot fail the way writing a byte can. The thread is
+    // always joined before the descriptors it polls are closed.
+    close(m_wake[1]);
+    m_thread.join();
+
+    close(m_wake[0]);
+    close(m_inotify);
+}
+
+void ShaderWatcher::watch_loop()
+{
+    alignas(inotify_event) char events[4096];
+
+    while (true) {
+        pollfd fds[2] = {
+            { .fd = m_inotify, .events = POLLIN, .revents = 0 },
+            { .fd = m_wake[0], .events = POLLIN, .revents = 0 },
+        };
+
+        if (poll(fds, 2, -1) == -1)
+            continue;
+
+        if (fds[1].revents != 0)
+            return;
+
+        ssize_t size = read(m_inotify, events, sizeof(events));
+        if (size <= 0)
+            continue;
+
+        for (char* event_data = events; event_data < events + size;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(event_data);
+            event_data += sizeof(inotify_event) + event->len;
+
+            if (event->len == 0)
+                continue;
+
+            std::vector<Watch> changed;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for (const Watch& watch : m_watches) {
+                    if (watch.directory == event->wd && watch.file_name == event->name)
+                        changed.push_back(watch);
+                }
+            }
+
+            for (const Watch& watch : changed) {
+                std::string source;
+                if (!read_source(watch.path, source)) {
+                    std::cerr << "ERROR: shader watcher: could not read `" << watch.path << "`\n";
+                    continue;
+                }
+
+                // Only the latest contents of a file are worth compiling
+                std::lock_guard<std::mutex> lock(m_mutex);
+                std::erase_if(m_changes, [&](const Change& change) {
+                    return change.shader == watch.shader;
+                });
+                m_changes.push_back({
+                    .shader = watch.shader,
+                    .source = std::move(source),
+                });
+            }
+        }
+    }
+}
+
+bool ShaderWatcher::watch(Shader* shader, const std::string& path)
+{
+    if (!is_valid())
+        return false;
+
+    std::size_t separator = path.rfind('/');
+    std::string directory = separator == std::string::npos ? "." : path.substr(0, separator + 1);
+    std::string file_name = separator == std::string::npos ? path : path.substr(separator + 1);
+
+    // Watching the same directory twice returns the same descriptor
+    int descriptor = inotify_add_watch(m_inotify, directory.c_str(), WATCH_EVENTS);
+    if (descriptor == -1) {
+        std::cerr << "ERROR: shader watcher: could not watch `" << path << "`\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_watches.push_back({
+        .shader = shader,
+        .path = path,
+        .directory = descriptor,
+        .file_name = file_name,
+    });
+
+    return true;
+}
+
+void ShaderWatcher::unwatch(Shader* shader)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (const Watch& watch : m_watches) {
+        if (watch.shader != shader)
+            continue;
+
+        bool shared = std::any_of(m_watches.begin(), m_watches.end(), [&](const Watch& other) {
+            return other.shader != shader && other.directory == watch.directory;
+        });
+        if (!shared)
+            inotify_rm_watch(m_inotify, watch.directory);
+    }
+
+    std::erase_if(m_watches, [&](const Watch& watch) { return watch.shader == shader; });
+    std::erase_if(m_changes, [&](const Change& change) { return change.shader == shader; });
+
+    if (std::find(m_reloading.begin(), m_reloading.end(), shader) != m_reloading.end()) {
+        shader->cancel_reload();
+        std::erase(m_reloading, shader);
+    }
+}
+
+bool ShaderWatcher::update()
+{
+    std::vector<Change> changes;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        changes.swap(m_changes);
+    }
+
+    for (const Change& change : changes) {
+        change.shader->reload(change.source);
+
+        if (change.shader->is_reloading()
+            && std::find(m_reloading.begin(), m_reloading.end(), change.shader) == m_reloading.end())
+            m_reloading.push_back(change.shader);
+    }
+
+    bool swapped = false;
+    for (Shader* shader : m_reloading) {
+        swapped = shader->finish_reload() || swapped;
+    }
+
+    std::erase_if(m_reloading, [](const Shader* shader) { return !shader->is_reloading(); });
+
+    return swapped;
+}
+
+}
+
+#else
+
+namespace GL {
+
+ShaderWatcher::ShaderWatcher()
+{
+    std::cerr << "ERROR: shader watcher: only supported on Linux\n";
+}
+
+ShaderWatcher::~ShaderWatcher() { }
+
+void ShaderWatcher::watch_loop() { }
+
+bool ShaderWatcher::watch(Shader* shader, const std::string& path)
+{
+    (void)shader;
+    (void)path;
+
+    return false;
+}
+
+void ShaderWatcher::unwatch(Shader* shader)
+{
+    (void)shader;
+}
+
+bool ShaderWatcher::update()
+{
+    return false;
+}
+
+}
+
+#endif
@@ -0,0 +1,90 @@
+#include "opengl/storage_buffer.hpp"
+
+#include "opengl/frame_stats.hpp"
+#include "opengl/gl_errors.hpp"
+#include "opengl/gpu_memory.hpp"
+#include "opengl/trace.hpp"
+
+namespace GL {
+
+ShaderStorageBuffer::ShaderStorageBuffer(GLenum usage)
+{
+    m_usage = usage;
+
+    gl(GenBuffers, (1, &m_id));
+}
+
+ShaderStorageBuffer::~ShaderStorageBuffer()
+{
+    gl(DeleteBuffers, (1, &m_id));
+
+    track_gpu_free(GpuResourceType::STORAGE_BUFFER, m_label, m_capacity);
+}
+
+void ShaderStorageBuffer::set_label(const std::string& label)
+{
+    track_gpu_relabel(m_label, label, m_capacity);
+    m_label = label;
+}
+
+void ShaderStorageBuffer::bind() const
+{
+    gl(BindBuffer, (GL_SHADER_STORAGE_BUFFER, m_id));
+}
+
+void ShaderStorageBuffer::unbind() const
+{
+    gl(BindBuffer, (GL_SHADER_STORAGE_BUFFER, 0));
+}
+
+void ShaderStorageBuffer::bind_base(GLuint index) const
+{
+    gl(BindBufferBase, (GL_SHADER_STORAGE_BUFFER, index, m_id));
+}
+
+void ShaderStorageBuffer::bind_vertices(const VertexLayout& layout) const
+{
+    gl(BindBuffer, (GL_ARRAY_BUFFER, m_id));
+    layout.apply();
+}
+
+void ShaderStorageBuffer::reserve(std::size_t size)
+{
+    m_size = size;
+
+    if (size <= m_capacity)
+        return;
+
+    bind();
+    gl(BufferData, (GL_SHADER_STORAGE_BUFFER, size, nullptr, m_usage));
+    unbind();
+
+    track_gpu_reallocation(GpuResourceType::STORAGE_BUFFER, m_label, m_capacity, size);
+    m_capacity = size;
+
+    frame_stats().buffer_reallocations += 1;
+}
+
+void ShaderStorageBuffer::upload(const void* data, std::size_t size)
+{
+    trace_scope("ShaderStorageBuffer::upload");
+
+    bind();
+
+    if (size > m_capacity) {
+        gl(BufferData, (GL_SHADER_STORAGE_BUFFER, size, data, m_usage));
+        track_gpu_reallocation(GpuResourceType::STORAGE_BUFFER, m_label, m_capacity, size);
+        m_capacity = size;
+        frame_stats().buffer_reallocations += 1;
+    } else {
+        gl(BufferSubData, (GL_SHADER_STORAGE_BUFFER, 0, size, data));
+    }
+
+    unbind();
+
+    m_size = size;
+
+    frame_stats().buffer_bytes_uploaded += size;
+}
+
+}
@@ -1,8 +1,14 @@
 #include "opengl/texture.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <utility>
 
+#include "opengl/frame_stats.hpp"
 #include "opengl/gl_errors.hpp"
+#include "opengl/gpu_memory.hpp"
+#include "opengl/trace.hpp"
 
 GLenum gl_magnification_filter = GL_LINEAR;
 GLenum gl_minification_filter = GL_LINEAR;
@@ -17,8 +23,12 @@ auto as_integer(Enumeration const value)
 }
 
 struct PixelFormat {
+    GLenum internal_format;
     GLenum format;
     GLenum type;
+    std::size_t bytes_per_pixel;
+    // Bytes per 4x4 block for compressed formats, 0 otherwise
+    std::size_t block_size;
 };
 
 static PixelFormat gl_pixel_format(GL::PixelFormat format)
@@ -27,14 +37,128 @@ static PixelFormat gl_pixel_format(GL::PixelFormat format)
 
     case GL::PixelFormat::R8G8B8:
         return {
+            .internal_format = GL_RGB8,
             .format = GL_RGB,
             .type = GL_UNSIGNED_BYTE,
+            .bytes_per_pixel = 3,
+            .block_size = 0,
         };
 
     case GL::PixelFormat::R8G8B8A8:
         return {
+            .internal_format = GL_RGBA8,
             .format = GL_RGBA,
             .type = GL_UNSIGNED_BYTE,
+            .bytes_per_pixel = 4,
+            .block_size = 0,
+        };
+
+    case GL::PixelFormat::R8:
+        return {
+            .internal_format = GL_R8,
+            .format = GL_RED,
+            .type = GL_UNSIGNED_BYTE,
+            .bytes_per_pixel = 1,
+            .block_size = 0,
+        };
+
+    case GL::PixelFormat::R8G8:
+        return {
+            .internal_format = GL_RG8,
+            .format = GL_RG,
+            .type = GL_UNSIGNED_BYTE,
+            .bytes_per_pixel = 2,
+            .block_size = 0,
+        };
+
+    case GL::PixelFormat::R16G16B16A16F:
+        return {
+            .internal_format = GL_RGBA16F,
+            .format = GL_RGBA,
+            .type = GL_HALF_FLOAT,
+            .bytes_per_pixel = 8,
+            .block_size = 0,
+        };
+
+    case GL::PixelFormat::R11G11B10F:
+        return {
+            .internal_format = GL_R11F_G11F_B10F,
+            .format = GL_RGB,
+            .type = GL_UNSIGNED_INT_10F_11F_11F_REV,
+            .bytes_per_pixel = 4,
+            .block_size = 0,
+        };
+
+    case GL::PixelFormat::SRGB8_ALPHA8:
+        return {
+            .internal_format = GL_SRGB8_ALPHA8,
+            .format = GL_RGBA,
+            .type = GL_UNSIGNED_BYTE,
+            .bytes_per_pixel = 4,
+            .block_size = 0,
+        };
+
+    case GL::PixelFormat::DEPTH24:
+        return {
+            .internal_format = GL_DEPTH_COMPONENT24,
+            .format = GL_DEPTH_COMPONENT,
+            .type = GL_UNSIGNED_INT,
+            .bytes_per_pixel = 4,
+            .block_size = 0,
+        };
+
+    case GL::PixelFormat::DEPTH32F:
+        return {
+            .internal_format = GL_DEPTH_COMPONENT32F,
+            .format = GL_DEPTH_COMPONENT,
+            .type = GL_FLOAT,
+            .bytes_per_pixel = 4,
+            .block_size = 0,
+        };
+
+    case GL::PixelFormat::DEPTH24_STENCIL8:
+        return {
+            .internal_format = GL_DEPTH24_STENCIL8,
+            .format = GL_DEPTH_STENCIL,
+            .type = GL_UNSIGNED_INT_24_8,
+            .bytes_per_pixel = 4,
+            .block_size = 0,
+        };
+
+    case GL::PixelFormat::BC1_RGBA:
+        return {
+            .internal_format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
+            .format = GL_RGBA,
+            .type = GL_UNSIGNED_BYTE,
+            .bytes_per_pixel = 0,
+            .block_size = 8,
+        };
+
+    case GL::PixelFormat::BC3_RGBA:
+        return {
+            .internal_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+            .format = GL_RGBA,
+            .type = GL_UNSIGNED_BYTE,
+            .bytes_per_pixel = 0,
+            .block_size = 16,
+        };
+
+    case GL::PixelFormat::BC7_RGBA:
+        return {
+            .internal_format = GL_COMPRESSED_RGBA_BPTC_UNORM,
+            .format = GL_RGBA,
+            .type = GL_UNSIGNED_BYTE,
+            .bytes_per_pixel = 0,
+            .block_size = 16,
+        };
+
+    case GL::PixelFormat::ETC2_RGBA8:
+        return {
+            .internal_format = GL_COMPRESSED_RGBA8_ETC2_EAC,
+            .format = GL_RGBA,
+            .type = GL_UNSIGNED_BYTE,
+            .bytes_per_pixel = 0,
+            .block_size = 16,
         };
 
     default:
@@ -60,39 +184,199 @@ static GLenum gl_texture_type(GL::TextureType type)
     }
 }
 
+// Picks the largest row alignment `row_size` satisfies, so tightly packed
+// rows of 1, 2 or 3 byte pixels are read correctly
+static GLint unpack_alignment(std::size_t row_size)
+{
+    if (row_size % 8 == 0)
+        return 8;
+    if (row_size % 4 == 0)
+        return 4;
+    if (row_size % 2 == 0)
+        return 2;
+    return 1;
+}
+
+// GL_UNPACK_ALIGNMENT is context state, it is put back to its default of 4
+// after each upload that needed a different one
+static void set_unpack_alignment(GLint alignment)
+{
+    if (alignment != 4)
+        gl(PixelStorei, (GL_UNPACK_ALIGNMENT, alignment));
+}
+
+static void reset_unpack_alignment(GLint alignment)
+{
+    if (alignment != 4)
+        gl(PixelStorei, (GL_UNPACK_ALIGNMENT, 4));
+}
+
+static void set_texture_parameters(GLenum target, std::size_t level_count)
+{
+    gl(TexParameteri, (target, GL_TEXTURE_MIN_FILTER, gl_minification_filter));
+    gl(TexParameteri, (target, GL_TEXTURE_MAG_FILTER, gl_magnification_filter));
+    gl(TexParameteri, (target, GL_TEXTURE_WRAP_S, gl_texture_wrap_s));
+    gl(TexParameteri, (target, GL_TEXTURE_WRAP_T, gl_texture_wrap_t));
+
+    // Partial mip chains are only complete if the texture knows where they end
+    gl(TexParameteri, (target, GL_TEXTURE_BASE_LEVEL, 0));
+    gl(TexParameteri, (target, GL_TEXTURE_MAX_LEVEL, level_count - 1));
+}
+
 namespace GL {
 
-Texture::Texture(unsigned char* pixels, std::size_t width, std::size_t height,
+bool is_compressed(PixelFormat format)
+{
+    return gl_pixel_format(format).block_size != 0;
+}
+
+bool is_pixel_format_supported(PixelFormat format)
+{
+    switch (format) {
+
+    case PixelFormat::BC1_RGBA:
+    case PixelFormat::BC3_RGBA:
+        return GLEW_EXT_texture_compression_s3tc;
+    case PixelFormat::BC7_RGBA:
+        return GLEW_ARB_texture_compression_bptc;
+    case PixelFormat::ETC2_RGBA8:
+        return GLEW_ARB_ES3_compatibility;
+
+    default:
+        return true;
+    }
+}
+
+std::size_t level_size(PixelFormat format, std::size_t width, std::size_t height)
+{
+    auto gl_format = gl_pixel_format(format);
+
+    if (gl_format.block_size == 0)
+        return width * height * gl_format.bytes_per_pixel;
+
+    auto blocks_x = std::max<std::size_t>(1, (width + 3) / 4);
+    auto blocks_y = std::max<std::size_t>(1, (height + 3) / 4);
+    return blocks_x * blocks_y * gl_format.block_size;
+}
+
+Texture::Texture(const unsigned char* pixels, std::size_t width, std::size_t height,
+                 PixelFormat pixel_format, TextureType type)
+    : Texture({ {
+                  .data = pixels,
+                  .size = level_size(pixel_format, width, height),
+                  .width = width,
+                  .height = height,
+              } },
+              pixel_format, type)
+{
+}
+
+Texture::Texture(const std::vector<TextureLevel>& levels,
                  PixelFormat pixel_format, TextureType type)
 {
+    trace_scope("Texture::upload");
+
     m_type = type;
+    m_pixel_format = pixel_format;
+
+    if (levels.empty()) {
+        std::cerr << "ERROR: texture has no levels to upload\n";
+        m_id = 0;
+        m_width = 0;
+        m_height = 0;
+        return;
+    }
+
+    m_width = levels[0].width;
+    m_height = levels[0].height;
+
+    if (!is_pixel_format_supported(pixel_format)) {
+        std::cerr << "ERROR: pixel format " << as_integer(pixel_format)
+                  << " is not supported by this OpenGL implementation\n";
+    }
 
     gl(GenTextures, (1, &m_id));
 
     gl(BindTexture, (gl_texture_type(type), m_id));
 
-    // Set parameters
-    gl(TexParameteri, (gl_texture_type(type), GL_TEXTURE_MIN_FILTER, gl_minification_filter));
-    gl(TexParameteri, (gl_texture_type(type), GL_TEXTURE_MAG_FILTER, gl_magnification_filter));
-    gl(TexParameteri, (gl_texture_type(type), GL_TEXTURE_WRAP_S, gl_texture_wrap_s));
-    gl(TexParameteri, (gl_texture_type(type), GL_TEXTURE_WRAP_T, gl_texture_wrap_t));
+    set_texture_parameters(gl_texture_type(type), levels.size());
 
     // Upload texture data
     auto format = gl_pixel_format(pixel_format);
-    gl(TexImage2D, (gl_texture_type(type), 0, GL_RGBA8, width, height, 0, format.format, format.type, pixels));
+    for (std::size_t i = 0; i < levels.size(); ++i) {
+        const TextureLevel& level = levels[i];
+
+        if (format.block_size != 0) {
+            gl(CompressedTexImage2D, (gl_texture_type(type), i, format.internal_format, level.width, level.height, 0, level.size, level.data));
+        } else {
+            auto alignment = unpack_alignment(level.width * format.bytes_per_pixel);
+            set_unpack_alignment(alignment);
+            gl(TexImage2D, (gl_texture_type(type), i, format.internal_format, level.width, level.height, 0, format.format, format.type, level.data));
+            reset_unpack_alignment(alignment);
+        }
+
+        m_size += level_size(pixel_format, level.width, level.height);
+    }
 
     gl(BindTexture, (gl_texture_type(type), 0));
+
+    track_gpu_allocation(GpuResourceType::TEXTURE, m_label, m_size);
 }
 
 Texture::~Texture()
 {
-    gl(DeleteTextures, (1, &m_id));
+    for (UploadSlot& slot : m_upload_ring) {
+        if (slot.fence != nullptr)
+            gl(DeleteSync, (slot.fence));
+        if (slot.buffer != 0)
+            gl(DeleteBuffers, (1, &slot.buffer));
+
+        track_gpu_free(GpuResourceType::STAGING_BUFFER, m_label, slot.capacity);
+    }
+
+    if (m_id != 0)
+        gl(DeleteTextures, (1, &m_id));
+
+    track_gpu_free(GpuResourceType::TEXTURE, m_label, m_size);
+}
+
+Texture::Texture(Texture&& other)
+{
+    m_id = 0;
+    *this = std::move(other);
+}
+
+Texture& Texture::operator=(Texture&& other)
+{
+    std::swap(m_id, other.m_id);
+    std::swap(m_type, other.m_type);
+    std::swap(m_pixel_format, other.m_pixel_format);
+    std::swap(m_width, other.m_width);
+    std::swap(m_height, other.m_height);
+    std::swap(m_size, other.m_size);
+    std::swap(m_label, other.m_label);
+    std::swap(m_upload_ring, other.m_upload_ring);
+    std::swap(m_upload_slot, other.m_upload_slot);
+
+    return *this;
+}
+
+void Texture::set_label(const std::string& label)
+{
+    std::size_t staging_size = 0;
+    for (const UploadSlot& slot : m_upload_ring)
+        staging_size += slot.capacity;
+
+    track_gpu_relabel(m_label, label, m_size + staging_size);
+    m_label = label;
 }
 
 void Texture::bind(GLuint slot) const
 {
     gl(ActiveTexture, (GL_TEXTURE0 + slot));
     gl(BindTexture, (gl_texture_type(m_type), m_id));
+
+    frame_stats().texture_binds += 1;
 }
 
 void Texture::unbind() const
@@ -101,6 +385,80 @@ void Texture::unbind() const
     gl(BindTexture, (gl_texture_type(m_type), 0));
 }
 
+void Texture::update_region(std::size_t x, std::size_t y,
+                            std::size_t width, std::size_t height,
+                            const unsigned char* pixels)
+{
+    trace_scope("Texture::update_region");
+
+    if (is_compressed(m_pixel_format)) {
+        std::cerr << "FATAL ERROR: update_region: "
+                  << "compressed textures cannot be updated\n";
+        throw;
+    }
+
+    if (x + width > m_width || y + height > m_height) {
+        std::cerr << "FATAL ERROR: update_region: "
+                  << "region is out of the texture bounds\n";
+        throw;
+    }
+
+    auto format = gl_pixel_format(m_pixel_format);
+    auto size = level_size(m_pixel_format, width, height);
+
+    // Mapping an empty range is an error
+    if (size == 0)
+        return;
+
+    UploadSlot& slot = m_upload_ring[m_upload_slot];
+    m_upload_slot = (m_upload_slot + 1) % m_upload_ring.size();
+
+    if (slot.buffer == 0)
+        gl(GenBuffers, (1, &slot.buffer));
+
+    gl(BindBuffer, (GL_PIXEL_UNPACK_BUFFER, slot.buffer));
+
+    // Only blocks when the ring wrapped around before the GPU consumed the
+    // upload that last used this slot
+    if (slot.fence != nullptr) {
+        gl(ClientWaitSync, (slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+        gl(DeleteSync, (slot.fence));
+        slot.fence = nullptr;
+    }
+
+    if (size > slot.capacity) {
+        gl(BufferData, (GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW));
+        track_gpu_reallocation(GpuResourceType::STAGING_BUFFER, m_label, slot.capacity, size);
+        slot.capacity = size;
+        frame_stats().buffer_reallocations += 1;
+    }
+
+    void* staging;
+    gl_call(staging = gl_fn(MapBufferRange)(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                            GL_MAP_WRITE_BIT
+                                                | GL_MAP_INVALIDATE_RANGE_BIT
+                                                | GL_MAP_UNSYNCHRONIZED_BIT));
+    if (staging == nullptr) {
+        std::cerr << "ERROR: update_region: could not map the staging buffer\n";
+        gl(BindBuffer, (GL_PIXEL_UNPACK_BUFFER, 0));
+        return;
+    }
+    std::memcpy(staging, pixels, size);
+    gl(UnmapBuffer, (GL_PIXEL_UNPACK_BUFFER));
+    frame_stats().buffer_bytes_uploaded += size;
+
+    gl(BindTexture, (gl_texture_type(m_type), m_id));
+    auto alignment = unpack_alignment(width * format.bytes_per_pixel);
+    set_unpack_alignment(alignment);
+    gl(TexSubImage2D, (gl_texture_type(m_type), 0, x, y, width, height, format.format, format.type, nullptr));
+    reset_unpack_alignment(alignment);
+    gl(BindTexture, (gl_texture_type(m_type), 0));
+
+    gl_call(slot.fence = gl_fn(FenceSync)(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    gl(BindBuffer, (GL_PIXEL_UNPACK_BUFFER, 0));
+}
+
 void set_magnification_filter(GLenum filter) { gl_magnification_filter = filter; }
 void set_minification_filter(GLenum filter) { gl_minification_filter = filter; }
 void set_texture_wrap_s(GLenum wrap) { gl_texture_wrap_s = wrap; }
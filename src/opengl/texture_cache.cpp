@@ -0,0 +1,166 @@
+#include "opengl/texture_cache.hpp"
+
+#include <iostream>
+#include <utility>
+
+#include "opengl/image.hpp"
+
+// 64-bit FNV-1a
+static std::uint64_t hash_bytes(const std::vector<unsigned char>& bytes)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+
+    for (unsigned char byte : bytes) {
+        hash ^= byte;
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+// Whether `path` still holds `bytes`
+static bool has_contents(const std::string& path, const std::vector<unsigned char>& bytes)
+{
+    std::vector<unsigned char> contents;
+    return GL::read_file(path, contents) && contents == bytes;
+}
+
+namespace GL {
+
+TextureRef::TextureRef(TextureCache* cache, std::uint64_t key,
+                       const Texture* texture)
+{
+    m_cache = cache;
+    m_key = key;
+    m_texture = texture;
+}
+
+TextureRef::~TextureRef()
+{
+    if (m_cache != nullptr)
+        m_cache->release(m_key);
+}
+
+TextureRef::TextureRef(TextureRef&& other)
+{
+    *this = std::move(other);
+}
+
+TextureRef& TextureRef::operator=(TextureRef&& other)
+{
+    std::swap(m_cache, other.m_cache);
+    std::swap(m_key, other.m_key);
+    std::swap(m_texture, other.m_texture);
+
+    return *this;
+}
+
+TextureRef TextureRef::share() const
+{
+    if (m_cache == nullptr)
+        return TextureRef();
+
+    m_cache->retain(m_key);
+
+    return TextureRef(m_cache, m_key, m_texture);
+}
+
+TextureCache::TextureCache(bool flip_vertically)
+{
+    m_flip_vertically = flip_vertically;
+}
+
+TextureCache::~TextureCache()
+{
+    if (!m_entries.empty()) {
+        std::cerr << "ERROR: TextureCache destroyed with "
+                  << m_entries.size() << " referenced texture(s)\n";
+    }
+
+    for (auto& [key, entry] : m_entries) {
+        delete entry.texture;
+    }
+}
+
+void TextureCache::retain(std::uint64_t key)
+{
+    m_entries.at(key).reference_count += 1;
+}
+
+void TextureCache::release(std::uint64_t key)
+{
+    auto it = m_entries.find(key);
+    Entry& entry = it->second;
+
+    entry.reference_count -= 1;
+    if (entry.reference_count > 0)
+        return;
+
+    for (const std::string& path : entry.paths) {
+        m_keys_by_path.erase(path);
+    }
+
+    delete entry.texture;
+    m_entries.erase(it);
+
+    m_stats.evictions += 1;
+}
+
+TextureRef TextureCache::reference(std::uint64_t key)
+{
+    Entry& entry = m_entries.at(key);
+    entry.reference_count += 1;
+
+    return TextureRef(this, key, entry.texture);
+}
+
+TextureRef TextureCache::load(const std::string& path)
+{
+    auto path_it = m_keys_by_path.find(path);
+    if (path_it != m_keys_by_path.end()) {
+        m_stats.path_hits += 1;
+        return reference(path_it->second);
+    }
+
+    std::vector<unsigned char> bytes;
+    if (!read_file(path, bytes))
+        return TextureRef();
+
+    // Colliding contents take the next free key
+    std::uint64_t key = hash_bytes(bytes);
+    for (auto entry_it = m_entries.find(key); entry_it != m_entries.end(); entry_it = m_entries.find(++key)) {
+        const Entry& entry = entry_it->second;
+        if (entry.size != bytes.size() || !has_contents(entry.paths.front(), bytes))
+            continue;
+
+        m_stats.content_hits += 1;
+
+        entry_it->second.paths.push_back(path);
+        m_keys_by_path[path] = key;
+
+        return reference(key);
+    }
+
+    std::size_t size = bytes.size();
+    Image image = decode_image(std::move(bytes), m_flip_vertically);
+    if (!image.is_valid()) {
+        std::cerr << "ERROR: could not load texture `" << path << "`\n";
+        return TextureRef();
+    }
+
+    m_stats.misses += 1;
+
+    m_entries[key] = {
+        .texture = new Texture(image.pixels(), image.width, image.height,
+                               image.format, TextureType::TWO_DIMS),
+        .reference_count = 0,
+        .paths = { path },
+        .size = size,
+    };
+    m_entries[key].texture->set_label(path);
+    m_keys_by_path[path] = key;
+
+    return reference(key);
+}
+
+}
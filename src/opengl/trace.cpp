@@ -0,0 +1,190 @@
+#include "opengl/trace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#ifdef OPENGL_TRACE
+
+// Thread 0 is the GPU timeline, CPU threads are numbered from 1 in the
+// order they first record a zone
+#define GPU_THREAD 0
+
+struct TraceEvent {
+    const char* name;
+    int thread;
+    std::int64_t start;
+    std::int64_t end;
+};
+
+static std::atomic<bool> tracing = false;
+static std::mutex trace_mutex;
+static std::string trace_path;
+static std::vector<TraceEvent> trace_events;
+static std::int64_t trace_start = 0;
+
+static std::atomic<int> next_thread = 1;
+
+static int trace_thread()
+{
+    thread_local int thread = next_thread++;
+    return thread;
+}
+
+static void write_escaped(std::ostream& out, const char* text)
+{
+    for (; *text != '\0'; ++text) {
+        if (*text == '"' || *text == '\\')
+            out << '\\';
+        out << *text;
+    }
+}
+
+static void write_thread_name(std::ostream& out, int thread, const char* name)
+{
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+        << ",\"args\":{\"name\":\"" << name << "\"}},\n";
+}
+
+namespace GL {
+
+bool start_trace(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(trace_mutex);
+
+    trace_path = path;
+    trace_events.clear();
+    trace_start = trace_clock();
+    tracing = true;
+
+    return true;
+}
+
+void stop_trace()
+{
+    std::vector<TraceEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        if (!tracing)
+            return;
+
+        tracing = false;
+        events.swap(trace_events);
+    }
+
+    std::ofstream out(trace_path);
+    if (!out) {
+        std::cerr << "ERROR: could not write trace `" << trace_path << "`\n";
+        return;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    write_thread_name(out, GPU_THREAD, "GPU");
+    for (int thread = 1; thread < next_thread; ++thread) {
+        std::string name = "CPU thread " + std::to_string(thread);
+        write_thread_name(out, thread, name.c_str());
+    }
+
+    // Complete events, with times in microseconds since the trace started.
+    // Written to the nanosecond, the default precision of 6 digits would
+    // round them to milliseconds in long traces.
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent& event = events[i];
+
+        out << "{\"name\":\"";
+        write_escaped(out, event.name);
+        out << "\",\"cat\":\"" << (event.thread == GPU_THREAD ? "gpu" : "cpu")
+            << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << (event.start - trace_start) / 1000.0
+            << ",\"dur\":" << (event.end - event.start) / 1000.0
+            << "}" << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+
+    out.flags(flags);
+    out.precision(precision);
+
+    out << "]}\n";
+
+    std::cout << "[INFO] Wrote " << events.size() << " trace events to `" << trace_path << "`\n";
+}
+
+bool is_tracing()
+{
+    return tracing.load(std::memory_order_relaxed);
+}
+
+std::int64_t trace_clock()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+void trace_cpu_zone(const char* name, std::int64_t start, std::int64_t end)
+{
+    int thread = trace_thread();
+
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    if (tracing)
+        trace_events.push_back({ .name = name, .thread = thread, .start = start, .end = end });
+}
+
+void trace_gpu_zone(const char* name, std::int64_t start, std::int64_t end)
+{
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    if (tracing)
+        trace_events.push_back({ .name = name, .thread = GPU_THREAD, .start = start, .end = end });
+}
+
+}
+
+#else
+
+namespace GL {
+
+bool start_trace(const std::string& path)
+{
+    (void)path;
+
+    std::cerr << "ERROR: the library was built without the trace option, no trace is recorded\n";
+    return false;
+}
+
+void stop_trace() { }
+
+bool is_tracing()
+{
+    return false;
+}
+
+std::int64_t trace_clock()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+void trace_cpu_zone(const char* name, std::int64_t start, std::int64_t end)
+{
+    (void)name;
+    (void)start;
+    (void)end;
+}
+
+void trace_gpu_zone(const char* name, std::int64_t start, std::int64_t end)
+{
+    (void)name;
+    (void)start;
+    (void)end;
+}
+
+}
+
+#endif
@@ -57,4 +57,12 @@ IndexBuffer* VertexArray::bind_index_buffer()
     return index_buffer;
 }
 
+void VertexArray::draw(const IndexBuffer& index_buffer, GLenum mode,
+                       std::size_t first_index, std::size_t index_count,
+                       GLint base_vertex) const
+{
+    bind();
+    index_buffer.draw(mode, first_index, index_count, base_vertex);
+}
+
 }
@@ -2,10 +2,28 @@
 
 #include <cstring>
 
+#include "opengl/frame_stats.hpp"
 #include "opengl/gl_errors.hpp"
+#include "opengl/gpu_memory.hpp"
+#include "opengl/trace.hpp"
 
 namespace GL {
 
+void VertexLayout::apply(GLuint first_location) const
+{
+    for (std::size_t i = 0; i < attributes.size(); ++i) {
+        const VertexAttribute& attribute = attributes[i];
+        GLuint location = first_location + i;
+
+        gl(EnableVertexAttribArray, (location));
+        gl(VertexAttribPointer, (location, attribute.component_count, attribute.component.type, attribute.normalized, stride, reinterpret_cast<GLvoid*>(attribute.offset)));
+
+        if (attribute.divisor != 0) {
+            gl(VertexAttribDivisor, (location, attribute.divisor));
+        }
+    }
+}
+
 VertexBuffer::VertexBuffer(const VertexLayout& layout)
 {
     m_layout = layout;
@@ -13,20 +31,21 @@ VertexBuffer::VertexBuffer(const VertexLayout& layout)
     gl(GenBuffers, (1, &m_id));
 
     bind();
-
-    for (std::size_t i = 0; i < layout.attributes.size(); ++i) {
-        const VertexAttribute& attribute = layout.attributes[i];
-
-        gl(EnableVertexAttribArray, (i));
-        gl(VertexAttribPointer, (i, attribute.component_count, attribute.component.type, attribute.normalized, layout.stride, reinterpret_cast<GLvoid*>(attribute.offset)));
-    }
-
+    layout.apply();
     unbind();
 }
 
 VertexBuffer::~VertexBuffer()
 {
     gl(DeleteBuffers, (1, &m_id));
+
+    track_gpu_free(GpuResourceType::VERTEX_BUFFER, m_label, m_capacity);
+}
+
+void VertexBuffer::set_label(const std::string& label)
+{
+    track_gpu_relabel(m_label, label, m_capacity);
+    m_label = label;
 }
 
 void VertexBuffer::bind() const
@@ -41,6 +60,8 @@ void VertexBuffer::unbind() const
 
 void VertexBuffer::resize(std::size_t added_size)
 {
+    trace_scope("VertexBuffer::resize");
+
     auto old_size = m_capacity;
     auto old_data = new unsigned char[old_size]();
     gl(GetBufferSubData, (GL_ARRAY_BUFFER, 0, old_size, old_data));
@@ -54,7 +75,11 @@ void VertexBuffer::resize(std::size_t added_size)
     delete[] old_data;
     delete[] new_data;
 
+    track_gpu_reallocation(GpuResourceType::VERTEX_BUFFER, m_label, m_capacity, new_size);
     m_capacity = new_size;
+
+    frame_stats().buffer_reallocations += 1;
+    frame_stats().buffer_bytes_uploaded += new_size;
 }
 
 void VertexBuffer::push_vertex(const void* data, std::size_t data_size)
@@ -72,6 +97,27 @@ void VertexBuffer::push_vertex(const void* data, std::size_t data_size)
     gl(BufferSubData, (GL_ARRAY_BUFFER, m_size, data_size, data));
 
     m_size += data_size;
+
+    frame_stats().vertices += 1;
+    frame_stats().buffer_bytes_uploaded += data_size;
+}
+
+void VertexBuffer::push_vertices(const void* data, std::size_t count)
+{
+    trace_scope("VertexBuffer::push_vertices");
+
+    auto data_size = count * m_layout.stride;
+
+    if ((m_size + data_size) > m_capacity) {
+        resize(m_size + data_size - m_capacity);
+    }
+
+    gl(BufferSubData, (GL_ARRAY_BUFFER, m_size, data_size, data));
+
+    m_size += data_size;
+
+    frame_stats().vertices += count;
+    frame_stats().buffer_bytes_uploaded += data_size;
 }
 
 void VertexBuffer::set_attribute(int vertex_index, int attribute_index,
@@ -87,6 +133,8 @@ void VertexBuffer::set_attribute(int vertex_index, int attribute_index,
     }
 
     gl(BufferSubData, (GL_ARRAY_BUFFER, vertex_index * m_layout.stride + attribute.offset, data_size, data));
+
+    frame_stats().buffer_bytes_uploaded += data_size;
 }
 
 }
@@ -1,15 +1,28 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <vector>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
+#include "opengl/asset_loader.hpp"
+#include "opengl/asset_pack.hpp"
+#include "opengl/compute_shader.hpp"
+#include "opengl/context.hpp"
+#include "opengl/frame_stats.hpp"
 #include "opengl/gl_errors.hpp"
+#include "opengl/gl_stats.hpp"
+#include "opengl/glfw_context.hpp"
+#include "opengl/gpu_memory.hpp"
+#include "opengl/gpu_profiler.hpp"
+#include "opengl/render_queue.hpp"
 #include "opengl/shader.hpp"
+#include "opengl/storage_buffer.hpp"
 #include "opengl/texture.hpp"
+#include "opengl/trace.hpp"
 #include "opengl/vertex_array.hpp"
 #include "opengl/vertex_buffer.hpp"
 
@@ -26,12 +39,6 @@ bool is_key_just_pressed(int key)
     return keys_pressed[key] && !prev_keys_pressed[key];
 }
 
-static void on_window_resize(GLFWwindow* window, int width, int height)
-{
-    (void)window;
-    gl(Viewport, (0, 0, width, height));
-}
-
 static void on_key(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
     (void)window;
@@ -44,21 +51,8 @@ static void on_key(GLFWwindow* window, int key, int scancode, int action, int mo
         keys_pressed[key] = false;
 }
 
-static GL::Texture read_texture_from_file(const std::string& filepath)
-{
-    int width;
-    int height;
-    int components;
-    unsigned char* pixels = stbi_load(filepath.c_str(), &width, &height, &components, 4);
-
-    auto texture = GL::Texture(pixels, width, height,
-                               GL::PixelFormat::R8G8B8A8,
-                               GL::TextureType::TWO_DIMS);
-
-    stbi_image_free(pixels);
-
-    return texture;
-}
+#define UPLOAD_BYTES_PER_FRAME (4 * 1024 * 1024)
+#define UPLOAD_TIME_PER_FRAME std::chrono::milliseconds(2)
 
 struct Vector2 {
     float x;
@@ -74,6 +68,30 @@ struct Vector4 {
 };
 #define V4X(v) v.x, v.y, v.z, v.w
 
+// Matches the std430 layout of `Sprite` in sprite_expand.glsl
+struct Sprite {
+    Vector2 position;
+    Vector2 size;
+    // Radians, around the center of the sprite
+    float rotation;
+    float padding[3];
+    Vector4 color;
+    // x, y, width, height in texture coordinates
+    Vector4 uv_rect;
+};
+
+#define SPRITE_VERTEX_SIZE (8 * sizeof(float))
+
+// `a_draw_id` in simple_renderer.glsl
+#define DRAW_ID_LOCATION 3
+
+// Index patterns stored once at the start of the index buffer, every
+// primitive is drawn from them at its own base vertex
+#define QUAD_FIRST_INDEX 0
+#define QUAD_INDEX_COUNT 6
+#define TRIANGLE_FIRST_INDEX 6
+#define TRIANGLE_INDEX_COUNT 3
+
 class Renderer {
 private:
     GL::VertexArray* m_va;
@@ -83,8 +101,75 @@ private:
     GL::Shader* m_shader;
     GL::Texture* m_default_texture;
 
+    // Draws are queued with their vertices appended to m_vb, and go out
+    // sorted by state at `end_drawing()`. The vertices of a frame stay in
+    // m_vb until the next `begin_drawing()`.
+    GL::RenderQueue* m_queue;
+    unsigned int m_layer = 0;
+    bool m_translucent = true;
+
+    // Sprites set with `set_sprites()` are expanded into vertices by
+    // `m_sprite_shader` when it is available, and on the CPU otherwise
+    GL::ComputeShader* m_sprite_shader = nullptr;
+    GL::ShaderStorageBuffer* m_sprites = nullptr;
+    GL::ShaderStorageBuffer* m_sprite_vertices = nullptr;
+    GL::VertexArray* m_sprite_va = nullptr;
+    GL::IndexBuffer* m_sprite_ib = nullptr;
+    std::size_t m_sprite_count = 0;
+    bool m_sprites_expanded = false;
+
+    std::vector<Sprite> m_cpu_sprites;
+
+    static void expand_sprite(const Sprite& sprite, float vertices[4][8])
+    {
+        static const Vector2 corners[4] = { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 0 } };
+
+        float s = std::sin(sprite.rotation);
+        float c = std::cos(sprite.rotation);
+        Vector2 center = { sprite.position.x + sprite.size.x * 0.5f,
+                           sprite.position.y + sprite.size.y * 0.5f };
+
+        for (int i = 0; i < 4; ++i) {
+            Vector2 offset = { (corners[i].x - 0.5f) * sprite.size.x,
+                               (corners[i].y - 0.5f) * sprite.size.y };
+
+            float vertex[] = {
+                center.x + offset.x * c - offset.y * s,
+                center.y + offset.x * s + offset.y * c,
+                sprite.uv_rect.x + corners[i].x * sprite.uv_rect.z,
+                sprite.uv_rect.y + (1.0f - corners[i].y) * sprite.uv_rect.w,
+                V4X(sprite.color),
+            };
+            std::memcpy(vertices[i], vertex, sizeof(vertex));
+        }
+    }
+
+    // Queues a draw of `vertex_count` vertices, using the index pattern at
+    // `first_index`
+    void push_draw(const GL::Texture& texture,
+                   const float* vertices, std::size_t vertex_count,
+                   std::size_t first_index, std::size_t index_count)
+    {
+        m_queue->push({
+            .layer = m_layer,
+            .translucent = m_translucent,
+            .depth = 0.0f,
+            .shader = m_shader,
+            .texture = &texture,
+            .vertex_array = m_va,
+            .index_buffer = m_ib,
+            .mode = GL_TRIANGLES,
+            .first_index = first_index,
+            .index_count = index_count,
+            .base_vertex = static_cast<GLint>(m_vb->vertex_count()),
+        });
+
+        m_vb->push_vertices(vertices, vertex_count);
+    }
+
 public:
-    static Renderer new_renderer()
+    // `sprite_shader` is optional, without it sprites are expanded on the CPU
+    static Renderer new_renderer(GL::Shader* shader, GL::ComputeShader* sprite_shader = nullptr)
     {
         Renderer renderer;
 
@@ -100,9 +185,38 @@ public:
 
         renderer.m_ib = renderer.m_va->bind_index_buffer();
 
+        renderer.m_vb->set_label("batch vertices");
+        renderer.m_ib->set_label("batch indices");
+
+        GLuint quad_indices[] = { 0, 1, 2, 2, 3, 0 };
+        GLuint triangle_indices[] = { 0, 1, 2 };
+        renderer.m_ib->push_indices(quad_indices, QUAD_INDEX_COUNT);
+        renderer.m_ib->push_indices(triangle_indices, TRIANGLE_INDEX_COUNT);
+
+        renderer.m_queue = new GL::RenderQueue();
+        renderer.m_queue->draws().enable_draw_id(DRAW_ID_LOCATION);
+
         renderer.m_va->unbind_all();
 
-        renderer.m_shader = new GL::Shader("./resources/shaders/simple_renderer.glsl");
+        // Every texture goes to slot 0
+        renderer.m_shader = shader;
+        renderer.m_shader->bind();
+        renderer.m_shader->set_uniform("u_texture_slot", 0);
+        renderer.m_shader->unbind();
+
+        if (sprite_shader != nullptr) {
+            renderer.m_sprite_shader = sprite_shader;
+            renderer.m_sprites = new GL::ShaderStorageBuffer(GL_STATIC_DRAW);
+            renderer.m_sprite_vertices = new GL::ShaderStorageBuffer(GL_DYNAMIC_COPY);
+            renderer.m_sprites->set_label("sprites");
+            renderer.m_sprite_vertices->set_label("sprite vertices");
+
+            renderer.m_sprite_va = new GL::VertexArray();
+            renderer.m_sprite_va->bind();
+            renderer.m_sprite_vertices->bind_vertices(vertex_layout);
+            renderer.m_sprite_ib = renderer.m_sprite_va->bind_index_buffer();
+            renderer.m_sprite_va->unbind_all();
+        }
 
         unsigned char pixels[] = { 0xFF, 0xFF, 0xFF, 0xFF };
         renderer.m_default_texture = new GL::Texture(pixels,
@@ -110,28 +224,50 @@ public:
                                                      1,
                                                      GL::PixelFormat::R8G8B8A8,
                                                      GL::TextureType::TWO_DIMS);
+        renderer.m_default_texture->set_label("default texture");
 
         return renderer;
     }
 
     ~Renderer()
     {
+        delete m_queue;
         delete m_default_texture;
         delete m_va;
         delete m_shader;
+
+        delete m_sprite_va;
+        delete m_sprite_vertices;
+        delete m_sprites;
+        delete m_sprite_shader;
     }
 
+    bool has_compute_sprites() const { return m_sprite_shader != nullptr; }
+
+    const GL::Texture& default_texture() const { return *m_default_texture; }
+
     void begin_drawing()
     {
         m_va->bind();
         m_ib->bind();
         m_vb->bind();
+
+        m_vb->clear();
     }
 
     void end_drawing()
     {
+        m_queue->submit();
     }
 
+    // Later layers are drawn over earlier ones, at most 255
+    void set_layer(unsigned int layer) { m_layer = layer; }
+    // Opaque draws of a layer are reordered to share state and drawn
+    // without blending, translucent ones keep their order
+    void set_translucent(bool translucent) { m_translucent = translucent; }
+
+    const GL::RenderQueueStats& stats() const { return m_queue->stats(); }
+
     void draw_texture(const GL::Texture& texture,
                       const Vector2& dst_position,
                       const Vector2& dst_size,
@@ -142,33 +278,13 @@ public:
         Vector2 c = { dst_position.x + dst_size.x, dst_position.y };
         Vector2 d = dst_position;
 
-        float a_vertex[] = { V2X(a), 0.0f, 0.0f, V4X(color_tint) };
-        float b_vertex[] = { V2X(b), 1.0f, 0.0f, V4X(color_tint) };
-        float c_vertex[] = { V2X(c), 1.0f, 1.0f, V4X(color_tint) };
-        float d_vertex[] = { V2X(d), 0.0f, 1.0f, V4X(color_tint) };
-
-        m_vb->push_vertex(a_vertex, sizeof(a_vertex));
-        m_vb->push_vertex(b_vertex, sizeof(b_vertex));
-        m_vb->push_vertex(c_vertex, sizeof(c_vertex));
-        m_vb->push_vertex(d_vertex, sizeof(d_vertex));
-
-        m_ib->push_index(0);
-        m_ib->push_index(1);
-        m_ib->push_index(2);
-
-        m_ib->push_index(2);
-        m_ib->push_index(3);
-        m_ib->push_index(0);
-
-        texture.bind(0);
-        m_shader->bind();
-
-        m_shader->set_uniform("u_texture_slot", 0);
-
-        gl(DrawElements, (GL_TRIANGLES, m_ib->index_count(), GL_UNSIGNED_INT, 0));
-
-        m_vb->clear();
-        m_ib->clear();
+        float vertices[] = {
+            V2X(a), 0.0f, 0.0f, V4X(color_tint),
+            V2X(b), 1.0f, 0.0f, V4X(color_tint),
+            V2X(c), 1.0f, 1.0f, V4X(color_tint),
+            V2X(d), 0.0f, 1.0f, V4X(color_tint),
+        };
+        push_draw(texture, vertices, 4, QUAD_FIRST_INDEX, QUAD_INDEX_COUNT);
     }
 
     void draw_triangle(const Vector2& a,
@@ -176,91 +292,296 @@ public:
                        const Vector2& c,
                        const Vector4& color)
     {
-        float a_vertex[] = { V2X(a), 0.0f, 0.0f, V4X(color) };
-        float b_vertex[] = { V2X(b), 1.0f, 0.0f, V4X(color) };
-        float c_vertex[] = { V2X(c), 1.0f, 1.0f, V4X(color) };
+        float vertices[] = {
+            V2X(a), 0.0f, 0.0f, V4X(color),
+            V2X(b), 1.0f, 0.0f, V4X(color),
+            V2X(c), 1.0f, 1.0f, V4X(color),
+        };
+        push_draw(*m_default_texture, vertices, 3, TRIANGLE_FIRST_INDEX, TRIANGLE_INDEX_COUNT);
+    }
 
-        m_vb->push_vertex(a_vertex, sizeof(a_vertex));
-        m_vb->push_vertex(b_vertex, sizeof(b_vertex));
-        m_vb->push_vertex(c_vertex, sizeof(c_vertex));
+    // Uploads the sprites drawn by `draw_sprites()`, they stay on the GPU
+    // until the next call
+    void set_sprites(const Sprite* sprites, std::size_t count)
+    {
+        m_sprite_count = count;
+
+        if (m_sprite_shader == nullptr) {
+            m_cpu_sprites.assign(sprites, sprites + count);
+            return;
+        }
+
+        m_sprites->upload(sprites, count * sizeof(Sprite));
+        m_sprite_vertices->reserve(count * 4 * SPRITE_VERTEX_SIZE);
+        m_sprites_expanded = false;
+
+        m_sprite_va->bind();
+        m_sprite_ib->bind();
+        for (std::size_t i = m_sprite_ib->index_count() / 6; i < count; ++i) {
+            GLuint base = i * 4;
+            GLuint indices[] = { base + 0, base + 1, base + 2, base + 2, base + 3, base + 0 };
+            m_sprite_ib->push_indices(indices, 6);
+        }
+        m_sprite_va->unbind_all();
+    }
 
-        m_ib->push_index(0);
-        m_ib->push_index(1);
-        m_ib->push_index(2);
+    void draw_sprites(const GL::Texture& texture)
+    {
+        if (m_sprite_count == 0)
+            return;
+
+        if (m_sprite_shader == nullptr) {
+            for (const Sprite& sprite : m_cpu_sprites) {
+                float vertices[4][8];
+                expand_sprite(sprite, vertices);
+
+                push_draw(texture, vertices[0], 4, QUAD_FIRST_INDEX, QUAD_INDEX_COUNT);
+            }
+            return;
+        }
+
+        // The sprites only change through `set_sprites()`, so they are
+        // expanded once per upload
+        if (!m_sprites_expanded) {
+            m_sprites->bind_base(0);
+            m_sprite_vertices->bind_base(1);
+
+            m_sprite_shader->bind();
+            m_sprite_shader->set_uniform("u_sprite_count", static_cast<int>(m_sprite_count));
+            m_sprite_shader->dispatch_items(m_sprite_count);
+
+            GL::memory_barrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+            m_sprites_expanded = true;
+        }
+
+        m_queue->push({
+            .layer = m_layer,
+            .translucent = m_translucent,
+            .depth = 0.0f,
+            .shader = m_shader,
+            .texture = &texture,
+            .vertex_array = m_sprite_va,
+            .index_buffer = m_sprite_ib,
+            .mode = GL_TRIANGLES,
+            .first_index = 0,
+            .index_count = m_sprite_count * 6,
+            .base_vertex = 0,
+        });
+    }
+};
 
-        m_default_texture->bind(0);
-        m_shader->bind();
+#define SPRITE_GRID_SIZE 32
 
-        m_shader->set_uniform("u_texture_slot", 0);
+// Frame counts of `--headless`, at least one frame
+static bool parse_frame_count(const char* text, long& frames)
+{
+    char* end = nullptr;
+    long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value <= 0)
+        return false;
 
-        gl(DrawElements, (GL_TRIANGLES, m_ib->index_count(), GL_UNSIGNED_INT, 0));
+    frames = value;
+    return true;
+}
 
-        m_vb->clear();
-        m_ib->clear();
+int main(int argc, char** argv)
+{
+    // Assets come from the asset pack given on the command line, if any,
+    // `--compute-sprites` expands a grid of sprites with a compute shader,
+    // `--headless <frames>` renders that many frames offscreen,
+    // `--profile-gpu` prints the GPU time of each pass on exit,
+    // `--trace <path>` records a Chrome trace of the run, `--gl-stats`
+    // prints the GL calls of every frame by call site, `--frame-stats`
+    // prints the draws, uploads and binds of every frame and `--gpu-memory`
+    // prints the GPU memory in use on exit
+    const char* pack_path = nullptr;
+    const char* trace_path = nullptr;
+    bool compute_sprites = false;
+    bool profile_gpu = false;
+    bool gl_stats = false;
+    bool frame_stats = false;
+    bool gpu_memory = false;
+    long frame_limit = -1;
+    GL::ContextConfig config = { .title = "Hello World" };
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--compute-sprites") == 0) {
+            compute_sprites = true;
+        } else if (std::strcmp(argv[i], "--profile-gpu") == 0) {
+            profile_gpu = true;
+        } else if (std::strcmp(argv[i], "--gl-stats") == 0) {
+            gl_stats = true;
+        } else if (std::strcmp(argv[i], "--frame-stats") == 0) {
+            frame_stats = true;
+        } else if (std::strcmp(argv[i], "--gpu-memory") == 0) {
+            gpu_memory = true;
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            if (i + 1 == argc || !parse_frame_count(argv[i + 1], frame_limit)) {
+                std::cerr << "ERROR: --headless needs a frame count greater than 0\n";
+                return 1;
+            }
+            config.headless = true;
+            i += 1;
+        } else {
+            pack_path = argv[i];
+        }
     }
-};
 
-int main(void)
-{
-    if (!glfwInit())
-        return -1;
+    // Compute shaders need OpenGL 4.3
+    if (compute_sprites)
+        config.major_version = 4;
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GL::Context* context = GL::create_context(config);
+    if (context == nullptr && compute_sprites) {
+        config.major_version = 3;
+        context = GL::create_context(config);
+    }
+    if (context == nullptr)
+        return 1;
 
-    GLFWwindow* window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);
-    if (!window) {
-        glfwTerminate();
-        return -1;
+    if (auto glfw_context = dynamic_cast<GL::GlfwContext*>(context)) {
+        glfwSetKeyCallback(glfw_context->window(), on_key);
     }
 
-    int major_ver = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MAJOR);
-    int minor_ver = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MINOR);
-    bool is_core = glfwGetWindowAttrib(window, GLFW_OPENGL_PROFILE) == GLFW_OPENGL_CORE_PROFILE;
-    std::cout << "[INFO] Context version: OpenGL "
-              << major_ver << "." << minor_ver
-              << (is_core ? " (Core Profile)" : "")
-              << "\n";
+    gl(Enable, (GL_BLEND));
+    gl(BlendFunc, (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
-    glfwSetKeyCallback(window, on_key);
-    glfwSetWindowSizeCallback(window, on_window_resize);
+    if (trace_path != nullptr)
+        GL::start_trace(trace_path);
 
-    glfwMakeContextCurrent(window);
+    GL::AssetPack* pack = pack_path != nullptr ? new GL::AssetPack(pack_path) : nullptr;
+    if (pack != nullptr && !pack->is_valid()) {
+        delete context;
+        return 1;
+    }
 
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "ERROR: could not load OpenGL\n";
-        std::cerr << "    > GLEW initialization failed!\n";
-        glfwTerminate();
+    GL::Shader* shader = pack != nullptr
+        ? pack->load_shader("simple_renderer")
+        : new GL::Shader("./resources/shaders/simple_renderer.glsl");
+    if (shader == nullptr) {
+        delete context;
         return 1;
     }
 
-    gl(Enable, (GL_BLEND));
-    gl(BlendFunc, (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    GL::ComputeShader* sprite_shader = nullptr;
+    if (compute_sprites && GL::is_compute_supported()) {
+        sprite_shader = pack != nullptr
+            ? pack->load_compute_shader("sprite_expand")
+            : new GL::ComputeShader("./resources/shaders/sprite_expand.glsl");
+        if (sprite_shader != nullptr && !sprite_shader->is_valid()) {
+            delete sprite_shader;
+            sprite_shader = nullptr;
+        }
+    }
+    if (compute_sprites && sprite_shader == nullptr) {
+        std::cout << "[INFO] Compute shaders are not available, sprites are expanded on the CPU\n";
+    }
+
+    auto renderer = new Renderer(Renderer::new_renderer(shader, sprite_shader));
+
+    if (compute_sprites) {
+        std::vector<Sprite> sprites;
+        for (int y = 0; y < SPRITE_GRID_SIZE; ++y) {
+            for (int x = 0; x < SPRITE_GRID_SIZE; ++x) {
+                float cell = 2.0f / SPRITE_GRID_SIZE;
+                sprites.push_back({
+                    .position = { -1.0f + x * cell, -1.0f + y * cell },
+                    .size = { cell * 0.8f, cell * 0.8f },
+                    .rotation = (x + y) * 0.1f,
+                    .padding = { 0, 0, 0 },
+                    .color = { float(x) / SPRITE_GRID_SIZE, float(y) / SPRITE_GRID_SIZE, 1, 1 },
+                    .uv_rect = { 0, 0, 1, 1 },
+                });
+            }
+        }
+        renderer->set_sprites(sprites.data(), sprites.size());
+    }
 
-    auto renderer = new Renderer(Renderer::new_renderer());
+    GL::AssetLoader* loader = new GL::AssetLoader(&renderer->default_texture());
+    auto texture = pack != nullptr
+        ? loader->add_texture(pack->load_texture("image"))
+        : loader->load_texture("./resources/textures/image.png");
 
-    GL::Texture* texture = new GL::Texture(read_texture_from_file("./resources/textures/image.png"));
+    // Timer queries cost a little every frame, so they are only issued
+    // when asked for
+    GL::GpuProfiler* profiler = profile_gpu ? new GL::GpuProfiler() : nullptr;
+
+    for (long frame = 0; !context->should_close() && frame != frame_limit; ++frame) {
+        trace_scope("frame");
+        if (profiler != nullptr) {
+            profiler->begin_frame();
+            profiler->begin_zone("frame");
+        }
+
+        gl(Clear, (GL_COLOR_BUFFER_BIT));
+
+        if (profiler != nullptr)
+            profiler->begin_zone("uploads");
+        loader->upload_pending(UPLOAD_BYTES_PER_FRAME, UPLOAD_TIME_PER_FRAME);
+        if (profiler != nullptr)
+            profiler->end_zone();
 
-    while (!glfwWindowShouldClose(window)) {
-        glClear(GL_COLOR_BUFFER_BIT);
         renderer->begin_drawing();
 
+        renderer->set_layer(0);
+        renderer->set_translucent(false);
         renderer->draw_triangle({ -0.5f, -0.5f },
                                 { +0.5f, -0.5f },
                                 { +0.5f, +0.5f },
                                 { 1.0f, 0.0f, 0.0f, 1.0f });
 
-        renderer->draw_texture(*texture, { 0, 0 }, { 1, 1 }, { 1, 1, 1, 1 });
-        renderer->draw_texture(*texture, { -1, -1 }, { 1, 1 }, { 1, 1, 1, 1 });
+        renderer->set_layer(1);
+        renderer->set_translucent(true);
+        renderer->draw_texture(loader->texture(texture), { 0, 0 }, { 1, 1 }, { 1, 1, 1, 1 });
+        renderer->draw_texture(loader->texture(texture), { -1, -1 }, { 1, 1 }, { 1, 1, 1, 1 });
 
+        renderer->draw_sprites(loader->texture(texture));
+
+        // Every draw of the frame, sprites included, is issued here by the
+        // render queue
+        if (profiler != nullptr)
+            profiler->begin_zone("draws");
         renderer->end_drawing();
+        if (profiler != nullptr) {
+            profiler->end_zone();
+            profiler->end_zone();
+            profiler->end_frame();
+        }
+
+        if (gl_stats)
+            std::cout << "[INFO] GL calls of frame " << frame << ":\n";
+        GL::end_gl_stats_frame(gl_stats ? &std::cout : nullptr);
+
+        GL::end_frame_stats();
+        if (frame_stats) {
+            std::cout << "[INFO] Frame " << frame << ":\n";
+            GL::print_frame_stats(std::cout, GL::last_frame_stats());
+        }
+
         std::memcpy(prev_keys_pressed, keys_pressed, sizeof(keys_pressed));
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        context->swap_buffers();
+        context->poll_events();
     }
 
+    GL::stop_trace();
+
+    if (profiler != nullptr) {
+        for (const GL::GpuZoneStats& zone : profiler->stats()) {
+            std::cout << "[INFO] GPU " << zone.path << ": "
+                      << "min " << zone.min << " ms, "
+                      << "avg " << zone.average << " ms, "
+                      << "max " << zone.max << " ms "
+                      << "over " << zone.samples << " frames\n";
+        }
+    }
+
+    if (gpu_memory)
+        GL::print_gpu_memory(std::cout);
+
+    delete profiler;
+    delete loader;
     delete renderer;
-    delete texture;
-    glfwTerminate();
+    delete pack;
+    delete context;
 }
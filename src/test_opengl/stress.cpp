@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "opengl/context.hpp"
+#include "opengl/gl_errors.hpp"
+#include "opengl/render_queue.hpp"
+#include "opengl/shader.hpp"
+#include "opengl/texture.hpp"
+#include "opengl/vertex_array.hpp"
+#include "opengl/vertex_buffer.hpp"
+
+// position, uv, color, as in stress.glsl
+#define VERTEX_FLOATS 8
+#define QUAD_INDEX_COUNT 6
+#define DRAW_ID_LOCATION 3
+
+#define TEXTURE_SIZE 64
+
+// Timer queries are read a few frames late, so that reading them does not
+// wait for the GPU
+#define GPU_QUERY_COUNT 4
+
+struct StressConfig {
+    std::size_t sprites = 10000;
+    std::size_t textures = 8;
+    std::size_t shader_variants = 4;
+    long frames = 500;
+    // Leading frames left out of the times, they pay for buffer growth and
+    // the driver's lazy setup
+    long warmup_frames = 10;
+    bool animate = false;
+    bool translucent = false;
+};
+
+struct FrameTimes {
+    double average;
+    double p50;
+    double p99;
+    double max;
+};
+
+// In milliseconds
+static FrameTimes summarize(std::vector<double> times)
+{
+    if (times.empty())
+        return { 0, 0, 0, 0 };
+
+    std::sort(times.begin(), times.end());
+
+    double total = 0;
+    for (double time : times)
+        total += time;
+
+    auto percentile = [&](double p) {
+        std::size_t index = static_cast<std::size_t>(p * (times.size() - 1) + 0.5);
+        return times[index];
+    };
+
+    return {
+        .average = total / times.size(),
+        .p50 = percentile(0.50),
+        .p99 = percentile(0.99),
+        .max = times.back(),
+    };
+}
+
+static void print_times(const char* name, const FrameTimes& times)
+{
+    std::cout << "    " << name << ": "
+              << "avg " << times.average << " ms, "
+              << "p50 " << times.p50 << " ms, "
+              << "p99 " << times.p99 << " ms, "
+              << "max " << times.max << " ms\n";
+}
+
+// Builds variant `variant` of the shader by defining VARIANT right after
+// the `#version` line of each stage. A `#line` directive follows it, so that
+// compiler logs keep the line numbers of the shader file.
+static GL::Shader* load_shader_variant(const std::string& path, const std::string& source, std::size_t variant)
+{
+    std::istringstream lines(source);
+    std::string variant_source;
+    std::string line;
+    // Compiler log lines are counted from the line after the `#shader` line
+    // of their stage in the variant source, which is moved down by the
+    // lines inserted into earlier stages
+    long stage_line = 0;
+    long inserted_lines = 0;
+    long stage_offset = 0;
+    while (std::getline(lines, line)) {
+        variant_source += line;
+        variant_source += '\n';
+
+        if (line.rfind("#shader", 0) == 0) {
+            stage_line = 0;
+            stage_offset = inserted_lines;
+            continue;
+        }
+
+        stage_line += 1;
+        if (line.rfind("#version", 0) == 0) {
+            variant_source += "#define VARIANT " + std::to_string(variant) + "\n";
+            variant_source += "#line " + std::to_string(stage_line + 1 - stage_offset) + "\n";
+            inserted_lines += 2;
+        }
+    }
+
+    return new GL::Shader(path + " (variant " + std::to_string(variant) + ")", variant_source);
+}
+
+// A checkerboard in a color of its own
+static GL::Texture* make_texture(std::size_t index)
+{
+    std::vector<unsigned char> pixels(TEXTURE_SIZE * TEXTURE_SIZE * 4);
+
+    unsigned char r = 96 + (index * 53) % 160;
+    unsigned char g = 96 + (index * 97) % 160;
+    unsigned char b = 96 + (index * 151) % 160;
+
+    for (std::size_t y = 0; y < TEXTURE_SIZE; ++y) {
+        for (std::size_t x = 0; x < TEXTURE_SIZE; ++x) {
+            bool dark = ((x / 8) + (y / 8)) % 2 == 0;
+            unsigned char* pixel = &pixels[(y * TEXTURE_SIZE + x) * 4];
+            pixel[0] = dark ? r / 2 : r;
+            pixel[1] = dark ? g / 2 : g;
+            pixel[2] = dark ? b / 2 : b;
+            pixel[3] = 0xFF;
+        }
+    }
+
+    return new GL::Texture(pixels.data(), TEXTURE_SIZE, TEXTURE_SIZE,
+                           GL::PixelFormat::R8G8B8A8, GL::TextureType::TWO_DIMS);
+}
+
+// Sprites sit on a grid covering the viewport, animated ones circle
+// around their cell
+static void sprite_vertices(std::size_t index, std::size_t count, float time, bool animate,
+                            float vertices[4][VERTEX_FLOATS])
+{
+    std::size_t columns = static_cast<std::size_t>(std::ceil(std::sqrt(double(count))));
+    float cell = 2.0f / columns;
+    float size = cell * 0.9f;
+
+    float x = -1.0f + (index % columns) * cell;
+    float y = -1.0f + (index / columns) * cell;
+    if (animate) {
+        float phase = time * 2.0f + index * 0.37f;
+        x += std::cos(phase) * cell * 0.25f;
+        y += std::sin(phase) * cell * 0.25f;
+    }
+
+    float quad[4][VERTEX_FLOATS] = {
+        { x, y + size, 0, 0, 1, 1, 1, 0.8f },
+        { x + size, y + size, 1, 0, 1, 1, 1, 0.8f },
+        { x + size, y, 1, 1, 1, 1, 1, 0.8f },
+        { x, y, 0, 1, 1, 1, 1, 0.8f },
+    };
+    std::memcpy(vertices, quad, sizeof(quad));
+}
+
+static bool parse_count(const char* text, std::size_t& count)
+{
+    char* end = nullptr;
+    long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value <= 0)
+        return false;
+
+    count = static_cast<std::size_t>(value);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    // Renders `--sprites N` sprites using `--textures M` textures and
+    // `--shaders K` variants of the stress shader for `--frames F` frames,
+    // in a window or offscreen with `--headless`, the first `--warmup W`
+    // frames are not measured. `--animate` moves the sprites every frame
+    // and `--translucent` draws them blended in submission order instead
+    // of sorted by state.
+    GL::ContextConfig config = { .title = "Stress" };
+    StressConfig stress;
+    const char* shader_path = "./resources/shaders/stress.glsl";
+
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        bool valid = true;
+
+        if (std::strcmp(argv[i], "--sprites") == 0 && has_value) {
+            valid = parse_count(argv[++i], stress.sprites);
+        } else if (std::strcmp(argv[i], "--textures") == 0 && has_value) {
+            valid = parse_count(argv[++i], stress.textures);
+        } else if (std::strcmp(argv[i], "--shaders") == 0 && has_value) {
+            valid = parse_count(argv[++i], stress.shader_variants);
+        } else if (std::strcmp(argv[i], "--frames") == 0 && has_value) {
+            std::size_t frames;
+            valid = parse_count(argv[++i], frames);
+            stress.frames = static_cast<long>(frames);
+        } else if (std::strcmp(argv[i], "--warmup") == 0 && has_value) {
+            stress.warmup_frames = std::atol(argv[++i]);
+        } else if (std::strcmp(argv[i], "--animate") == 0) {
+            stress.animate = true;
+        } else if (std::strcmp(argv[i], "--translucent") == 0) {
+            stress.translucent = true;
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            config.headless = true;
+        } else if (argv[i][0] != '-') {
+            shader_path = argv[i];
+        } else {
+            valid = false;
+        }
+
+        if (!valid) {
+            std::cerr << "ERROR: invalid argument `" << argv[i] << "`\n";
+            return 1;
+        }
+    }
+
+    GL::Context* context = GL::create_context(config);
+    if (context == nullptr)
+        return 1;
+
+    std::ifstream shader_file(shader_path, std::ios::binary);
+    if (!shader_file) {
+        std::cerr << "ERROR: could not open shader `" << shader_path << "`\n";
+        delete context;
+        return 1;
+    }
+    std::string shader_source((std::istreambuf_iterator<char>(shader_file)), std::istreambuf_iterator<char>());
+
+    std::vector<GL::Shader*> shaders;
+    for (std::size_t i = 0; i < stress.shader_variants; ++i) {
+        GL::Shader* shader = load_shader_variant(shader_path, shader_source, i);
+        if (!shader->is_valid()) {
+            delete shader;
+            for (GL::Shader* loaded : shaders)
+                delete loaded;
+            delete context;
+            return 1;
+        }
+
+        shader->bind();
+        shader->set_uniform("u_texture_slot", 0);
+        shaders.push_back(shader);
+    }
+
+    std::vector<GL::Texture*> textures;
+    for (std::size_t i = 0; i < stress.textures; ++i)
+        textures.push_back(make_texture(i));
+
+    GL::VertexArray* va = new GL::VertexArray();
+    va->bind();
+
+    GL::VertexLayout vertex_layout;
+    vertex_layout.add_attribute<float>(2, false);
+    vertex_layout.add_attribute<float>(2, false);
+    vertex_layout.add_attribute<float>(4, false);
+    GL::VertexBuffer* vb = va->bind_vertex_buffer(vertex_layout);
+
+    GL::IndexBuffer* ib = va->bind_index_buffer();
+    GLuint quad_indices[] = { 0, 1, 2, 2, 3, 0 };
+    ib->push_indices(quad_indices, QUAD_INDEX_COUNT);
+
+    GL::RenderQueue* queue = new GL::RenderQueue();
+    queue->draws().enable_draw_id(DRAW_ID_LOCATION);
+    va->unbind_all();
+
+    gl(BlendFunc, (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+
+    GLuint gpu_queries[GPU_QUERY_COUNT];
+    gl(GenQueries, (GPU_QUERY_COUNT, gpu_queries));
+    long gpu_queries_read = 0;
+
+    std::vector<double> cpu_times;
+    std::vector<double> gpu_times;
+    cpu_times.reserve(stress.frames);
+    gpu_times.reserve(stress.frames);
+
+    auto read_gpu_query = [&](bool wait) {
+        GLuint query = gpu_queries[gpu_queries_read % GPU_QUERY_COUNT];
+
+        if (!wait) {
+            GLint available = GL_FALSE;
+            gl(GetQueryObjectiv, (query, GL_QUERY_RESULT_AVAILABLE, &available));
+            if (!available)
+                return false;
+        }
+
+        GLuint64 nanoseconds = 0;
+        gl(GetQueryObjectui64v, (query, GL_QUERY_RESULT, &nanoseconds));
+        if (gpu_queries_read >= stress.warmup_frames)
+            gpu_times.push_back(nanoseconds / 1e6);
+        gpu_queries_read += 1;
+        return true;
+    };
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+
+    long frame = 0;
+    for (; !context->should_close() && frame != stress.frames; ++frame) {
+        auto frame_start = Clock::now();
+        float time = std::chrono::duration<float>(frame_start - start).count();
+
+        // The oldest query is reused for this frame, so it has to be read
+        // first even if the GPU is that far behind
+        while (gpu_queries_read < frame && read_gpu_query(frame - gpu_queries_read >= GPU_QUERY_COUNT))
+            ;
+
+        gl(BeginQuery, (GL_TIME_ELAPSED, gpu_queries[frame % GPU_QUERY_COUNT]));
+        gl(Clear, (GL_COLOR_BUFFER_BIT));
+
+        va->bind();
+        ib->bind();
+        vb->bind();
+        vb->clear();
+
+        for (std::size_t i = 0; i < stress.sprites; ++i) {
+            float vertices[4][VERTEX_FLOATS];
+            sprite_vertices(i, stress.sprites, time, stress.animate, vertices);
+
+            queue->push({
+                .layer = 0,
+                .translucent = stress.translucent,
+                .depth = 0.0f,
+                .shader = shaders[i % shaders.size()],
+                .texture = textures[i % textures.size()],
+                .vertex_array = va,
+                .index_buffer = ib,
+                .mode = GL_TRIANGLES,
+                .first_index = 0,
+                .index_count = QUAD_INDEX_COUNT,
+                .base_vertex = static_cast<GLint>(vb->vertex_count()),
+            });
+            vb->push_vertices(vertices[0], 4);
+        }
+
+        queue->submit();
+        gl(EndQuery, (GL_TIME_ELAPSED));
+
+        context->swap_buffers();
+        context->poll_events();
+
+        if (frame >= stress.warmup_frames)
+            cpu_times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - frame_start).count());
+    }
+
+    while (gpu_queries_read < frame)
+        read_gpu_query(true);
+
+    const GL::RenderQueueStats& stats = queue->stats();
+    std::cout << "[INFO] " << frame << " frames (" << cpu_times.size() << " measured), "
+              << stress.sprites << " sprites, "
+              << stress.textures << " textures, "
+              << stress.shader_variants << " shader variants"
+              << (stress.animate ? ", animated" : "")
+              << (stress.translucent ? ", translucent" : "") << "\n"
+              << "    per frame: " << stats.draw_calls << " draw calls, "
+              << stats.shader_binds << " shader binds, "
+              << stats.texture_binds << " texture binds\n";
+    print_times("CPU", summarize(cpu_times));
+    print_times("GPU", summarize(gpu_times));
+
+    gl(DeleteQueries, (GPU_QUERY_COUNT, gpu_queries));
+
+    delete queue;
+    delete va;
+    for (GL::Texture* texture : textures)
+        delete texture;
+    for (GL::Shader* shader : shaders)
+        delete shader;
+    delete context;
+}
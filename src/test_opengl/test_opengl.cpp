@@ -1,14 +1,19 @@
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
-
+#include "opengl/asset_loader.hpp"
+#include "opengl/asset_pack.hpp"
+#include "opengl/command_buffer.hpp"
+#include "opengl/context.hpp"
 #include "opengl/gl_errors.hpp"
+#include "opengl/glfw_context.hpp"
 #include "opengl/shader.hpp"
+#include "opengl/shader_watcher.hpp"
 #include "opengl/texture.hpp"
 #include "opengl/vertex_array.hpp"
 
@@ -25,29 +30,8 @@ static bool is_key_just_pressed(int key)
     return keys_pressed[key] && !prev_keys_pressed[key];
 }
 
-static GL::Texture read_texture_from_file(const std::string& filepath)
-{
-    stbi_set_flip_vertically_on_load(1);
-
-    int width;
-    int height;
-    int components;
-    unsigned char* pixels = stbi_load(filepath.c_str(), &width, &height, &components, 4);
-
-    auto texture = GL::Texture(pixels, width, height,
-                               GL::PixelFormat::R8G8B8A8,
-                               GL::TextureType::TWO_DIMS);
-
-    stbi_image_free(pixels);
-
-    return texture;
-}
-
-static void on_window_resize(GLFWwindow* window, int width, int height)
-{
-    (void)window;
-    gl(Viewport, (0, 0, width, height));
-}
+#define UPLOAD_BYTES_PER_FRAME (4 * 1024 * 1024)
+#define UPLOAD_TIME_PER_FRAME std::chrono::milliseconds(2)
 
 static void on_key(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
@@ -61,45 +45,59 @@ static void on_key(GLFWwindow* window, int key, int scancode, int action, int mo
         keys_pressed[key] = false;
 }
 
-int main()
+// Frame counts of `--headless`, at least one frame
+static bool parse_frame_count(const char* text, long& frames)
 {
-    if (!glfwInit())
-        return -1;
+    char* end = nullptr;
+    long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value <= 0)
+        return false;
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    frames = value;
+    return true;
+}
 
-    GLFWwindow* window = glfwCreateWindow(640, 480, "Hello World", nullptr, nullptr);
-    if (!window) {
-        std::cerr << "ERROR: could not initialize GLFW\n";
-        glfwTerminate();
-        return 1;
+int main(int argc, char** argv)
+{
+    // Assets come from the asset pack given on the command line, if any,
+    // `--watch-shaders` reloads shaders whenever their file changes and
+    // `--headless <frames>` renders that many frames offscreen
+    const char* pack_path = nullptr;
+    bool watch_shaders = false;
+    long frame_limit = -1;
+    GL::ContextConfig config = { .title = "Hello World" };
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--watch-shaders") == 0) {
+            watch_shaders = true;
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            if (i + 1 == argc || !parse_frame_count(argv[i + 1], frame_limit)) {
+                std::cerr << "ERROR: --headless needs a frame count greater than 0\n";
+                return 1;
+            }
+            config.headless = true;
+            i += 1;
+        } else {
+            pack_path = argv[i];
+        }
     }
 
-    glfwSetWindowSizeCallback(window, on_window_resize);
-    glfwSetKeyCallback(window, on_key);
-
-    glfwMakeContextCurrent(window);
-
-    if (glewInit() != GLEW_OK) {
-        std::cerr << "ERROR: could not load OpenGL\n";
-        std::cerr << "    > GLEW initialization failed!\n";
-        glfwTerminate();
+    GL::Context* context = GL::create_context(config);
+    if (context == nullptr)
         return 1;
-    }
 
-    int major_ver = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MAJOR);
-    int minor_ver = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MINOR);
-    bool is_core = glfwGetWindowAttrib(window, GLFW_OPENGL_PROFILE) == GLFW_OPENGL_CORE_PROFILE;
-    std::cout << "[INFO] Context version: OpenGL "
-              << major_ver << "." << minor_ver
-              << (is_core ? " (Core Profile)" : "")
-              << "\n";
+    if (auto glfw_context = dynamic_cast<GL::GlfwContext*>(context)) {
+        glfwSetKeyCallback(glfw_context->window(), on_key);
+    }
 
     gl(Enable, (GL_BLEND));
     gl(BlendFunc, (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
+    GL::AssetPack* pack = pack_path != nullptr ? new GL::AssetPack(pack_path) : nullptr;
+    if (pack != nullptr && !pack->is_valid()) {
+        delete context;
+        return 1;
+    }
+
     /*                    *
      *   Setup vertexes   *
      *                    */
@@ -132,20 +130,26 @@ int main()
     vertexes_layout.add_attribute<float>(2, false); // Texture coordinate
 
     GL::VertexBuffer* vb = va->bind_vertex_buffer(vertexes_layout);
-    vb->push_vertex(&vertexes[0], vertexes_layout.stride);
-    vb->push_vertex(&vertexes[4], vertexes_layout.stride);
-    vb->push_vertex(&vertexes[8], vertexes_layout.stride);
-    vb->push_vertex(&vertexes[12], vertexes_layout.stride);
-
     GL::IndexBuffer* ib = va->bind_index_buffer();
 
-    ib->push_index(0);
-    ib->push_index(1);
-    ib->push_index(2);
-
-    ib->push_index(2);
-    ib->push_index(3);
-    ib->push_index(0);
+    GL::MeshView quad;
+    if (pack != nullptr && pack->mesh("quad", vertexes_layout.stride, quad)) {
+        vb->push_vertices(quad.vertices, quad.vertex_count);
+        ib->push_indices(quad.indices, quad.index_count);
+    } else {
+        vb->push_vertex(&vertexes[0], vertexes_layout.stride);
+        vb->push_vertex(&vertexes[4], vertexes_layout.stride);
+        vb->push_vertex(&vertexes[8], vertexes_layout.stride);
+        vb->push_vertex(&vertexes[12], vertexes_layout.stride);
+
+        ib->push_index(0);
+        ib->push_index(1);
+        ib->push_index(2);
+
+        ib->push_index(2);
+        ib->push_index(3);
+        ib->push_index(0);
+    }
 
     va->unbind_all();
 
@@ -153,29 +157,54 @@ int main()
      *   Setup texture   *
      *                   */
 
-    GL::Texture* texture = new GL::Texture(read_texture_from_file("./resources/textures/image.png"));
+    unsigned char white_pixel[] = { 0xFF, 0xFF, 0xFF, 0xFF };
+    GL::Texture* placeholder_texture = new GL::Texture(white_pixel, 1, 1,
+                                                       GL::PixelFormat::R8G8B8A8,
+                                                       GL::TextureType::TWO_DIMS);
+
+    GL::AssetLoader* loader = new GL::AssetLoader(placeholder_texture);
+    auto texture = pack != nullptr
+        ? loader->add_texture(pack->load_texture("image_flipped"))
+        : loader->load_texture("./resources/textures/image.png", true);
 
     /*                  *
      *   Setup shader   *
      *                  */
 
     std::string shader_path = "./resources/shaders/default.glsl";
-    GL::Shader* shader = new GL::Shader(GL::Shader(shader_path));
-    shader->bind();
-    if (!shader->is_valid()) {
+    GL::Shader* shader = pack != nullptr
+        ? pack->load_shader("default")
+        : new GL::Shader(shader_path);
+    if (shader == nullptr || !shader->is_valid()) {
         return 1;
     }
+    shader->bind();
 
     shader->set_uniform("u_color", 1.0f, 1.0f, 1.0f, 1.0f);
 
     shader->unbind();
 
+    GL::ShaderWatcher* watcher = nullptr;
+    if (watch_shaders) {
+        watcher = new GL::ShaderWatcher();
+        watcher->watch(shader, shader_path);
+    }
+
     /*               *
      *   Main loop   *
      *               */
 
-    while (!glfwWindowShouldClose(window)) {
-        gl(Clear, (GL_COLOR_BUFFER_BIT));
+    // The frame is recorded first and then replayed, recording makes no GL
+    // call and could happen on another thread
+    GL::CommandBuffer* commands = new GL::CommandBuffer();
+
+    for (long frame = 0; !context->should_close() && frame != frame_limit; ++frame) {
+        loader->upload_pending(UPLOAD_BYTES_PER_FRAME, UPLOAD_TIME_PER_FRAME);
+
+        if (watcher != nullptr && watcher->update()) {
+            shader->bind();
+            shader->set_uniform("u_color", 1.0f, 1.0f, 1.0f, 1.0f);
+        }
 
         vb->bind();
         if (is_key_just_pressed(GLFW_KEY_ENTER)) {
@@ -184,23 +213,29 @@ int main()
         }
         vb->unbind();
 
-        shader->bind();
-
-        texture->bind(0);
-        shader->set_uniform("u_texture_slot", 0);
+        commands->clear(GL_COLOR_BUFFER_BIT);
+        commands->bind_shader(*shader);
+        commands->bind_texture(loader->texture(texture), 0);
+        commands->set_uniform(*shader, "u_texture_slot", 0);
+        commands->bind_vertex_array(*va);
+        commands->draw(*ib, GL_TRIANGLES, 0, ib->index_count());
 
-        va->bind();
-        gl(DrawElements, (GL_TRIANGLES, ib->index_count(), GL_UNSIGNED_INT, nullptr));
+        commands->execute();
+        commands->reset();
 
         std::memcpy(prev_keys_pressed, keys_pressed, sizeof(keys_pressed));
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        context->swap_buffers();
+        context->poll_events();
     }
 
+    delete commands;
+    delete watcher;
     delete va;
     delete shader;
-    delete texture;
-    glfwTerminate();
+    delete loader;
+    delete placeholder_texture;
+    delete pack;
+    delete context;
 
     return 0;
 }